@@ -39,6 +39,22 @@ namespace move {
         return move != Invalid;
     }
 
+    bool is_quiet(const chess_move& move) {
+        return defender(move) == chess::EmptyPiece && 
+               flag(move) != move_flag::EnPassantCapture && flag(move) < move_flag::PromoteToKnight;
+    }
+
+    uint16_t pack(const chess_move& move) {
+        if (!is_valid(move)) return 0;
+        return from(move) | (to(move) << 6) | (static_cast<uint8_t>(flag(move)) << 12);
+    }
+
+    chess_move unpack(uint16_t packed, uint8_t attacker_type, uint8_t defender_type) {
+        if (packed == 0) return Invalid;
+        return make_move(packed & 0x3F, (packed >> 6) & 0x3F, attacker_type, defender_type,
+                         static_cast<move_flag>(packed >> 12));
+    }
+
     string to_string(const chess_move& move) {
         stringstream ss;
         int from_row = move::from(move) / 8;
@@ -34,7 +34,17 @@ namespace move {
     uint8_t attacker(const chess_move& move);
     uint8_t defender(const chess_move& move);
     bool is_valid(const chess_move& move);
+    bool is_quiet(const chess_move& move); // neither a capture nor a promotion
     std::string to_string(const chess_move& move);
+
+    /**
+     * Packs from, to and flag into 16 bits, attacker and defender must be restored from the board.
+     * [0-5 bits] from
+     * [6-11 bits] to
+     * [12-15 bits] flag
+     */
+    uint16_t pack(const chess_move& move);
+    chess_move unpack(uint16_t packed, uint8_t attacker_type, uint8_t defender_type);
 }
 
 #endif //CHESSUCIENGINE_CHESS_MOVE_H
@@ -12,6 +12,8 @@
 
 namespace chess_move_generator {
     using namespace std;
+    
+    enum class move_type { All, Captures, Quiets };
 
     inline bitboard attackers_to(const game_state& state, bitboard occupied, uint8_t position, uint8_t side) {
         bitboard result = 0;
@@ -103,13 +105,15 @@ namespace chess_move_generator {
         }
     }
     
-    inline void generate_figure_moves_pawn(move_list& moves, const game_state& state, uint8_t side, bool only_captures, bitboard pinned, uint8_t king_sq, bitboard target) {
-        if (!only_captures) {
+    template <move_type Type>
+    inline void generate_figure_moves_pawn(move_list& moves, const game_state& state, uint8_t side, bitboard pinned, uint8_t king_sq, bitboard target) {
+        if constexpr (Type != move_type::Captures) {
             auto short_moves = legal_move_mask::generate_short_pawn_mask(state, side);
             auto long_moves = legal_move_mask::generate_long_pawn_mask(state, side);
             generate_pawn_moves(moves, state, side, side == chess::White ? -8 : 8, false, short_moves & target, move::move_flag::Default, pinned, king_sq);
             generate_pawn_moves(moves, state, side, side == chess::White ? -16 : 16, false, long_moves & target, move::move_flag::PawnLongMove, pinned, king_sq);
         }
+        if constexpr (Type == move_type::Quiets) return;
         auto left_captures = legal_move_mask::generate_left_pawn_capture_mask(state, side, false) & target;
         auto right_captures = legal_move_mask::generate_right_pawn_capture_mask(state, side, false) & target;
         generate_pawn_moves(moves, state, side, side == chess::White ? -7 : 9, true, left_captures, move::move_flag::Default, pinned, king_sq);
@@ -139,25 +143,35 @@ namespace chess_move_generator {
         }
     }
 
+    inline bool can_castle_long(const game_state& state, uint8_t side) {
+        auto index = side == chess::White ? 0 : 56; // index of the first cell in the castling row
+        return state.castling[side][chess::Queen] &&   // castling available => rook and king are on their positions 
+               get_bit(state.empty, index + 1) &&      // |
+               get_bit(state.empty, index + 2) &&      // | no figures between king and rook
+               get_bit(state.empty, index + 3) &&      // |
+               !in_danger(state, state.all, index + 2, side) &&   // king's target cell is not under attack
+               !in_danger(state, state.all, index + 3, side) &&   // king's passing cell is not under attack
+               !in_danger(state, state.all, index + 4, side);     // king itself is not under attack
+    }
+
+    inline bool can_castle_short(const game_state& state, uint8_t side) {
+        auto index = side == chess::White ? 0 : 56; // index of the first cell in the castling row
+        return state.castling[side][chess::King] &&    // castling available => rook and king are on their positions
+               get_bit(state.empty, index + 5) &&      // |
+               get_bit(state.empty, index + 6) &&      // | no figures between king and rook
+               !in_danger(state, state.all, index + 4, side) &&   // king itself is not under attack
+               !in_danger(state, state.all, index + 5, side) &&   // king's passing cell is not under attack
+               !in_danger(state, state.all, index + 6, side);     // king's target cell is not under attack
+    }
+
     inline void generate_castling_moves(move_list& moves, const game_state& state, uint8_t side) {
         auto index = side == chess::White ? 0 : 56; // index of the first cell in the castling row
         auto long_flag = side == chess::White ? move::move_flag::WhiteLongCastling : move::move_flag::BlackLongCastling;
         auto short_flag = side == chess::White ? move::move_flag::WhiteShortCastling : move::move_flag::BlackShortCastling;
-        if (state.castling[side][chess::Queen] &&   // castling available => rook and king are on their positions 
-            get_bit(state.empty, index + 1) &&      // |
-            get_bit(state.empty, index + 2) &&      // | no figures between king and rook
-            get_bit(state.empty, index + 3) &&      // |
-            !in_danger(state, state.all, index + 2, side) &&   // king's target cell is not under attack
-            !in_danger(state, state.all, index + 3, side) &&   // king's passing cell is not under attack
-            !in_danger(state, state.all, index + 4, side)) {   // king itself is not under attack
+        if (can_castle_long(state, side)) {
             moves.push_back(move::make_move(index + 4, index + 2, chess::King, chess::EmptyPiece, long_flag));
         }
-        if (state.castling[side][chess::King] &&    // castling available => rook and king are on their positions
-            get_bit(state.empty, index + 5) &&      // |
-            get_bit(state.empty, index + 6) &&      // | no figures between king and rook
-            !in_danger(state, state.all, index + 4, side) &&   // king itself is not under attack
-            !in_danger(state, state.all, index + 5, side) &&   // king's passing cell is not under attack
-            !in_danger(state, state.all, index + 6, side)) {   // king's target cell is not under attack
+        if (can_castle_short(state, side)) {
             moves.push_back(move::make_move(index + 4, index + 6, chess::King, chess::EmptyPiece, short_flag));
         }
     }
@@ -179,14 +193,19 @@ namespace chess_move_generator {
         return result;
     }
 
-    inline void generate_all_moves(move_list& moves, const game_state& state, uint8_t side, bool only_captures = false) {
-        Assert(moves.size() == 0)
+    /**
+     * Appends legal moves of the given type to the list: captures include en passant and capturing promotions,
+     * quiets include pawn pushes with promotions and castling.
+     */
+    template <move_type Type>
+    inline void generate_moves_of_type(move_list& moves, const game_state& state, uint8_t side) {
         auto king_position = lsb(state.board[side][chess::King]);
         auto checkers = attackers_to(state, state.all, king_position, side);
         auto checkers_count = count_1(checkers);
         auto pinned = get_absolute_pinned(state, side);
-        bitboard target = only_captures ? state.side_board[chess::inverse_color(side)]
-                                        : state.inv_side_board[side];
+        bitboard target = Type == move_type::Captures ? state.side_board[chess::inverse_color(side)]
+                        : Type == move_type::Quiets ? state.empty
+                        : state.inv_side_board[side];
 
         generate_figure_moves<chess::King>(moves, state, side, 0, king_position, target);
 
@@ -196,17 +215,88 @@ namespace chess_move_generator {
                 auto checker = lsb(checkers);
                 target &= in_between_mask::mask[king_position][checker] | (1ULL << checker);
             }
-            generate_figure_moves_pawn(moves, state, side, only_captures, pinned, king_position, target);
+            generate_figure_moves_pawn<Type>(moves, state, side, pinned, king_position, target);
             generate_figure_moves<chess::Knight>(moves, state, side, pinned, king_position, target);
             generate_figure_moves<chess::Rook>(moves, state, side, pinned, king_position, target);
             generate_figure_moves<chess::Bishop>(moves, state, side, pinned, king_position, target);
             generate_figure_moves<chess::Queen>(moves, state, side, pinned, king_position, target);
-            generate_en_passant_moves(moves, state, side);
-            if (!checkers && !only_captures) {
+            if constexpr (Type != move_type::Quiets) {
+                generate_en_passant_moves(moves, state, side);
+            }
+            if (!checkers && Type != move_type::Captures) {
                 generate_castling_moves(moves, state, side);
             }
         }
     }
+
+    inline void generate_all_moves(move_list& moves, const game_state& state, uint8_t side, bool only_captures = false) {
+        Assert(moves.size() == 0)
+        if (only_captures) {
+            generate_moves_of_type<move_type::Captures>(moves, state, side);
+        } else {
+            generate_moves_of_type<move_type::All>(moves, state, side);
+        }
+    }
+
+    inline bitboard generate_figure_mask(uint8_t figure, uint8_t position, bitboard occupied) {
+        switch (figure) {
+            case chess::Queen: return legal_move_mask::generate_figure_mask<chess::Queen>(position, occupied);
+            case chess::King: return legal_move_mask::generate_figure_mask<chess::King>(position, occupied);
+            case chess::Rook: return legal_move_mask::generate_figure_mask<chess::Rook>(position, occupied);
+            case chess::Knight: return legal_move_mask::generate_figure_mask<chess::Knight>(position, occupied);
+            case chess::Bishop: return legal_move_mask::generate_figure_mask<chess::Bishop>(position, occupied);
+            default: return 0;
+        }
+    }
+
+    /**
+     * Checks that the move could have been generated in this position if the own king was ignored,
+     * including attacker and defender types. Used to validate moves that come from other positions:
+     * transposition table moves (after a key collision) and killers.
+     */
+    inline bool is_pseudo_legal(const chess_move& move, const game_state& state) {
+        if (!move::is_valid(move)) return false;
+        auto side = state.side;
+        auto from = move::from(move);
+        auto to = move::to(move);
+        auto attacker = move::attacker(move);
+        auto defender = move::defender(move);
+        auto flag = move::flag(move);
+        if (from >= 64 || to >= 64 || flag > move::move_flag::PromoteToQueen) return false;
+        if (attacker > chess::MaxPiece || !get_bit(state.board[side][attacker], from)) return false;
+        if (get_bit(state.side_board[side], to) || state.get_piece(chess::inverse_color(side), to) != defender) return false;
+        if (defender == chess::King) return false;
+
+        if (flag >= move::move_flag::WhiteLongCastling && flag <= move::move_flag::BlackShortCastling) {
+            auto index = side == chess::White ? 0 : 56;
+            bool is_white_flag = flag == move::move_flag::WhiteLongCastling || flag == move::move_flag::WhiteShortCastling;
+            bool is_long = flag == move::move_flag::WhiteLongCastling || flag == move::move_flag::BlackLongCastling;
+            return is_white_flag == (side == chess::White) && attacker == chess::King && from == index + 4 &&
+                   to == index + (is_long ? 2 : 6) && (is_long ? can_castle_long(state, side) : can_castle_short(state, side));
+        }
+        if (attacker != chess::Pawn) {
+            return flag == move::move_flag::Default && get_bit(generate_figure_mask(attacker, from, state.all), to);
+        }
+
+        auto captures = side == chess::White ? pawn_masks::white_mask[from] : pawn_masks::black_mask[from];
+        int forward = side == chess::White ? 8 : -8;
+        if (flag == move::move_flag::EnPassantCapture) {
+            return to == state.en_passant && get_bit(captures, to);
+        }
+        bool is_promotion = flag >= move::move_flag::PromoteToKnight;
+        if (is_promotion != (to < 8 || to > 55)) return false;
+        if (flag == move::move_flag::PawnLongMove) {
+            auto start_row = side == chess::White ? 1 : 6;
+            return from / 8 == start_row && to == from + 2 * forward && 
+                   get_bit(state.empty, from + forward) && get_bit(state.empty, to);
+        }
+        if (defender != chess::EmptyPiece) return get_bit(captures, to);
+        return to == from + forward;
+    }
+
+    inline bool is_valid_move(const chess_move& move, const game_state& state) {
+        return is_pseudo_legal(move, state) && is_legal(move, state);
+    }
 }
 
 #endif //CHESSUCIENGINE_CHESS_MOVE_GENERATOR_H
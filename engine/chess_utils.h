@@ -18,6 +18,8 @@ namespace chess {
     static constexpr uint8_t MinPiece = Queen;
     static constexpr uint8_t MaxPiece = Pawn;
     static constexpr size_t MaxLegalMoves = 256;
+    static constexpr int32_t MateScore = 30000;
+    static constexpr int32_t MateThreshold = MateScore - 1000; // scores above are mates within search depth
 
     inline uint8_t inverse_color(uint8_t side) {
         return side == White ? Black : White;
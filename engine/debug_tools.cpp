@@ -11,15 +11,14 @@ void debug_tools::print_values_for_moves(const string& fen) {
     game_state state(fen);
     move_list moves;
     chess_move_generator::generate_all_moves(moves, state, state.side);
-    transposition_table table;
-    killer_table ktable;
+    constexpr int depth = 6;
     dynamic_evaluator evaluator;
+    // every root move is a line of one multi-PV search, so the values share the iterations and the table
+    evaluator.multi_pv = moves.size();
+    evaluator.info_callback = [](const search_info& info) {
+        if (info.depth != depth) return;
+        cout << move::to_string(info.best_move) << " => " << info.score << " cp" << endl;
+    };
     cout << "initial value: " << static_evaluator::evaluate(state) << " cp" << endl;
-    for (const auto& move : moves) {
-        game_state new_state(state);
-        new_state.apply_move(move);
-        auto value = evaluator.pvs(new_state, table, ktable, 6, 1, -1000000000, 1000000000,
-                                   new_state.side == chess::White ? 1 : -1);
-        cout << move::to_string(move) << " => " << /*static_evaluator::evaluate(new_state)*/value << " cp" << endl;
-    }
+    evaluator.find_best_move(state, depth);
 }
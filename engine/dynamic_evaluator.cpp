@@ -1,183 +1,759 @@
 #include "dynamic_evaluator.h"
 #include "chess_move_generator.h"
 #include "static_evaluator.h"
+#include "move_picker.h"
 #include <limits>
 #include <algorithm>
-
-#define CollectStatistics false
-#if CollectStatistics
-#define Stat(block) block
-#else
-#define Stat(block)
-#endif
+#include <thread>
+#include <memory>
+#include <cmath>
+#include <optional>
 
 using namespace std;
 
-dynamic_evaluator::dynamic_evaluator() :
-        pool(), max_depth(0), main_search_nodes(0), zero_window_nodes(0), capture_search_nodes(0), 
-        transposition_found(0), transposition_best_hit(0), pvs_research_count(0), indices(), evaluations() {}
+const array<array<int, dynamic_evaluator::LateMoveTableSize>, dynamic_evaluator::LateMoveTableSize> 
+dynamic_evaluator::late_move_reductions = []() {
+    array<array<int, LateMoveTableSize>, LateMoveTableSize> result{};
+    for (size_t depth = 1; depth < LateMoveTableSize; depth++) {
+        for (size_t index = 1; index < LateMoveTableSize; index++) {
+            result[depth][index] = static_cast<int>(0.75 + log(depth) * log(index) / 2.25);
+        }
+    }
+    return result;
+}();
+
+dynamic_evaluator::dynamic_evaluator(int threads, size_t hash_size_mb) :
+        table(hash_size_mb > 0 ? make_unique<transposition_table>(hash_size_mb) : nullptr), stack(), 
+        root_depth(0), seldepth(0), root_ply(0), last_null_ply(0), root_line(0), threads(threads),
+        stop_requested(false), ponderhit_requested(false), stop_flag(&stop_requested), stopped(false), 
+        next_limits_check(0), root_side(chess::White), hash_size_mb(hash_size_mb), singular_extensions(true), 
+        probcut_margin(DefaultProbCutMargin), probcut_reduction(DefaultProbCutReduction), multi_pv(1), nodes(0), total_nodes(0),
+        ponder_move(move::Invalid) {
+    init_helpers();
+}
+
+int dynamic_evaluator::late_move_reduction(int depth, int move_index, bool is_check, const chess_move& move,
+                                           const killer_moves& killers) {
+    // only quiet moves at the end of the ordered list are reduced, tactical and checking moves are searched fully
+    if (!search_features::LateMoveReductions) return 0;
+    if (depth < LateMoveMinDepth || move_index < LateMoveMinIndex || is_check || 
+        !move::is_quiet(move) || killers.contains(move)) return 0;
+    int reduction = late_move_reductions[min<size_t>(depth, LateMoveTableSize - 1)][min<size_t>(move_index, LateMoveTableSize - 1)];
+    return min(reduction, depth - 2);
+}
 
-int32_t dynamic_evaluator::eval_move(const chess_move& move, const game_state& state, bitboard pawn_capture_mask, bool is_killer) {
-    int32_t result = 0;
-    if (move::attacker(move) != chess::Pawn && get_bit(pawn_capture_mask, move::to(move))) {
-        result -= static_evaluator::material_cost[move::attacker(move)];
+bool dynamic_evaluator::is_table_cutoff(const transposition_table::probe_result& entry, int depth, int32_t alpha, int32_t beta) {
+    if (!entry.found || entry.depth < depth) return false;
+    switch (entry.bound_type) {
+        case transposition_table::bound::Exact: return true;
+        case transposition_table::bound::Lower: return entry.score >= beta;
+        case transposition_table::bound::Upper: return entry.score <= alpha;
+        default: return false;
     }
-    if (move::defender(move) != chess::EmptyPiece) {
-        result += 1000 * static_evaluator::material_cost[move::defender(move)];
-        result -= static_evaluator::material_cost[move::attacker(move)];
+}
+
+void dynamic_evaluator::stop() {
+    stop_requested = true;
+}
+
+void dynamic_evaluator::ponderhit() {
+    ponderhit_requested = true;
+}
+
+void dynamic_evaluator::clear_stop() {
+    stop_requested = false;
+    ponderhit_requested = false;
+}
+
+bool dynamic_evaluator::is_stop_requested() const {
+    return stop_requested;
+}
+
+bool dynamic_evaluator::is_ponderhit_requested() const {
+    return ponderhit_requested;
+}
+
+void dynamic_evaluator::set_threads(int32_t threads) {
+    this->threads = threads;
+    init_helpers();
+}
+
+void dynamic_evaluator::init_helpers() {
+    helpers.resize(max(0, threads - 1));
+    for (auto& helper : helpers) {
+        if (!helper) helper = make_unique<dynamic_evaluator>(1, 0);
+    }
+}
+
+void dynamic_evaluator::set_hash_size(size_t size_mb) {
+    hash_size_mb = size_mb;
+    table->resize(size_mb);
+}
+
+void dynamic_evaluator::new_game() {
+    table->clear();
+    history.clear();
+    stack.clear();
+    helpers.clear();
+    init_helpers();
+}
+
+void dynamic_evaluator::count_node() {
+    // nodes are written by this thread only, the atomic is needed for reading by the main thread 
+    nodes.store(nodes.load(memory_order_relaxed) + 1, memory_order_relaxed);
+}
+
+search_statistics dynamic_evaluator::statistics() const {
+    auto result = stats.snapshot();
+    for (const auto& helper : helpers) {
+        result += helper->stats.snapshot();
     }
-    if (is_killer) { // place killers right after all captures
-        result += 10000;
+    return result;
+}
+
+const vector<root_move>& dynamic_evaluator::get_root_moves() const {
+    return root_moves;
+}
+
+uint64_t dynamic_evaluator::searched_nodes() const {
+    uint64_t result = nodes.load(memory_order_relaxed);
+    for (const auto& helper : helpers) {
+        result += helper->nodes.load(memory_order_relaxed);
     }
     return result;
 }
 
-void dynamic_evaluator::sort_moves(move_list& moves, const game_state& state, uint8_t side,
-                                   const chess_move& hash_move, const killer_table& ktable, int real_depth) {
-    bitboard pawn_capture_mask =
-            legal_move_mask::generate_left_pawn_capture_mask(state, chess::inverse_color(side), true) |
-            legal_move_mask::generate_right_pawn_capture_mask(state, chess::inverse_color(side), true);
-    for (int i = 0; i < moves.size(); i++) {
-        indices[real_depth][i] = i;
-        evaluations[i] = moves[i] == hash_move
-                         ? Infinity
-                         : eval_move(moves[i], state, pawn_capture_mask, ktable.is_killer(real_depth, moves[i]));
+void dynamic_evaluator::check_limits() {
+    next_limits_check = nodes.load(memory_order_relaxed) + LimitsCheckInterval;
+    if (limits.ponder && ponderhit_requested.load(memory_order_relaxed)) {
+        // the search goes on, only the clock starts now
+        limits.ponder = false;
+        timer.init(limits, root_side);
+    }
+    if (stop_flag->load(memory_order_relaxed) || timer.hard_limit_reached() ||
+        (limits.nodes > 0 && searched_nodes() >= limits.nodes)) {
+        stopped = true;
     }
-    sort(indices[real_depth].begin(), indices[real_depth].begin() + moves.size(), [this](const auto& a, const auto& b) {
-        return evaluations[a] > evaluations[b];
-    });
+}
+
+bool dynamic_evaluator::is_stopped() {
+    if (!stopped && nodes.load(memory_order_relaxed) >= next_limits_check) {
+        check_limits();
+    }
+    return stopped;
+}
+
+/**
+ * The second move of the principal variation, taken from the hash move of the position after the best move.
+ */
+chess_move dynamic_evaluator::find_ponder_move(const game_state& state, const chess_move& best_move) {
+    if (!move::is_valid(best_move)) return move::Invalid;
+    game_state next(state);
+    next.apply_move(best_move);
+    auto entry = table->probe(next, 2);
+    if (!entry.found || !chess_move_generator::is_valid_move(entry.best_move, next)) return move::Invalid;
+    return entry.best_move;
 }
 
 chess_move dynamic_evaluator::find_best_move(const game_state& state, int depth) {
-    transposition_table table;
-    killer_table ktable;
+    search_limits depth_limits;
+    depth_limits.depth = depth;
+    return find_best_move(state, depth_limits);
+}
+
+chess_move dynamic_evaluator::find_best_move(const game_state& state, const search_limits& limits) {
+    timer.init(limits, state.side);
+    this->limits = limits;
+    root_side = state.side;
+    table->new_search();
+    init_line_keys();
+    stopped = false;
+    nodes = 0;
+    stats.clear();
+    next_limits_check = LimitsCheckInterval;
+    int depth = limits.depth > 0 ? min(limits.depth, MaxSearchDepth) : MaxSearchDepth;
+
+    // Lazy SMP: helpers search the same root with their own search stacks, 
+    // sharing only the transposition table. Odd helpers are shifted by one ply to diversify the search.
+    // Helpers are kept between searches along with their history and killers.
+    atomic<bool> stop_helpers(false);
+    vector<thread> helper_threads;
+    for (int i = 1; i < threads; i++) {
+        auto& helper = helpers[i - 1];
+        helper->stop_flag = &stop_helpers;
+        helper->stopped = false;
+        helper->nodes = 0;
+        helper->stats.clear();
+        helper->next_limits_check = LimitsCheckInterval;
+        helper->singular_extensions = singular_extensions;
+        helper->probcut_margin = probcut_margin;
+        helper->probcut_reduction = probcut_reduction;
+        helper->limits.searchmoves = limits.searchmoves;
+        helper->game_history = game_history;
+        helper->init_line_keys();
+        helper_threads.emplace_back([helper = helper.get(), &state, table = table.get(), depth, i]() {
+            chess_move helper_best_move = move::Invalid;
+            helper->iterative_deepening(state, *table, 1 + i % 2, depth + i % 2, helper_best_move);
+        });
+    }
+
     chess_move best_move = move::Invalid;
-    int color = state.side == chess::White ? 1 : -1;
-    for (int dd = 1; dd <= depth; dd++) {
-        pvs(state, table, ktable, dd, 1, -numeric_limits<int32_t>::max(), numeric_limits<int32_t>::max(), color, &best_move);
+    iterative_deepening(state, *table, 1, depth, best_move);
+    
+    stop_helpers = true;
+    for (auto& helper_thread : helper_threads) {
+        helper_thread.join();
     }
-    Assert(move::is_valid(best_move))
+    total_nodes = searched_nodes();
+    if (!move::is_valid(best_move)) {
+        // stopped before the first iteration completed
+        move_list moves;
+        chess_move_generator::generate_all_moves(moves, state, state.side);
+        if (moves.size() > 0) best_move = moves[0];
+    }
+    ponder_move = find_ponder_move(state, best_move);
     return best_move;
 }
 
-int32_t dynamic_evaluator::pvs(const game_state& state, transposition_table& table, killer_table& ktable, // NOLINT(misc-no-recursion)
-                               int depth, int real_depth, int32_t alpha, int32_t beta, 
-                               int color, chess_move* best_move) {
-    Stat(max_depth = max(max_depth, real_depth);)
-    Stat(main_search_nodes++;)
-    Assert(real_depth < MaxDepth)
-    if (depth == 0) return nega_max_captures(state, real_depth, alpha, beta, color);
+void dynamic_evaluator::init_line_keys() {
+    line_keys = game_history;
+    root_ply = line_keys.size();
+    line_keys.resize(root_ply + search_stack::MaxPly);
+    last_null_ply = 0;
+}
+
+void dynamic_evaluator::iterative_deepening(const game_state& state, transposition_table& table,
+                                            int from_depth, int to_depth, chess_move& best_move) {
+    int color = state.side == chess::White ? 1 : -1;
+    game_state root(state); // moves are made and unmade on this state during the search
+    init_root_moves(root, table);
+    if (root_moves.empty()) return;
+    size_t lines = min(root_moves.size(), multi_pv);
+    vector<int32_t> scores(lines, 0);
+    for (int dd = from_depth; dd <= to_depth; dd++) {
+        history.age();
+        root_depth = dd;
+        seldepth = 0;
+        stack[1].extension = 0;
+        for (auto& move : root_moves) {
+            move.nodes = 0;
+        }
+        // every next line is searched without the root moves of the previous ones, which are kept in front
+        for (size_t line = 0; line < lines; line++) {
+            chess_move line_move = root_moves[line].move;
+            int32_t score = aspiration_search(root, table, dd, dd - from_depth >= AspirationMinDepth,
+                                              scores[line], color, line, line_move);
+            if (line == 0) best_move = line_move;
+            if (is_stopped()) break;
+            // a later line may score above an earlier one, the lines are kept sorted by score
+            root_moves[line].score = score;
+            stable_sort(root_moves.begin(), root_moves.begin() + static_cast<ptrdiff_t>(line) + 1,
+                        [](const root_move& a, const root_move& b) { return a.score > b.score; });
+            for (size_t i = 0; i <= line; i++) {
+                scores[i] = root_moves[i].score;
+            }
+            best_move = root_moves[0].move;
+        }
+        // root move is written only when the root search completes, so an aborted iteration is discarded
+        if (is_stopped()) break;
+        if (info_callback) {
+            for (size_t line = 0; line < lines; line++) {
+                info_callback(search_info {dd, seldepth, root_moves[line].score, searched_nodes(), timer.elapsed(), 
+                                           root_moves[line].move, line + 1});
+            }
+        }
+        if (timer.soft_limit_reached()) break;
+    }
+}
+
+/**
+ * Root moves in the order of the move picker, restricted to the searchmoves of the limits.
+ */
+void dynamic_evaluator::init_root_moves(const game_state& root, transposition_table& table) {
+    root_moves.clear();
+    auto entry = table.probe(root, 1);
+    move_picker picker(stack[1], root, entry.best_move, history, move::Invalid);
+    for (chess_move move = picker.next(); move::is_valid(move); move = picker.next()) {
+        if (!limits.searchmoves.empty() && 
+            find(limits.searchmoves.begin(), limits.searchmoves.end(), move) == limits.searchmoves.end()) continue;
+        root_moves.push_back(root_move {move, -Infinity, 0});
+    }
+}
+
+/**
+ * Searches the line in a window around its score from the previous iteration, widened on every fail.
+ * The best move is updated unless the search fails low.
+ */
+int32_t dynamic_evaluator::aspiration_search(game_state& root, transposition_table& table,
+                                             int depth, bool use_window, int32_t score, int color, 
+                                             size_t line, chess_move& best_move) {
+    int32_t delta = AspirationWindow;
+    int32_t alpha = -numeric_limits<int32_t>::max();
+    int32_t beta = numeric_limits<int32_t>::max();
+    if (use_window && abs(score) < chess::MateThreshold) {
+        alpha = score - delta;
+        beta = score + delta;
+    }
+    while (true) {
+        root_line = line;
+        score = search<node_type::Root>(root, table, depth, 1, alpha, beta, color);
+        if (is_stopped()) return score;
+        if (score <= alpha) {
+            // root move of a failed low search is not reliable, keep the previous one
+            stats.increment(search_statistics::AspirationFailLow);
+            beta = static_cast<int32_t>((static_cast<int64_t>(alpha) + beta) / 2);
+            alpha = delta < AspirationMaxWindow ? score - delta : -numeric_limits<int32_t>::max();
+        } else if (score >= beta) {
+            stats.increment(search_statistics::AspirationFailHigh);
+            best_move = root_moves[line].move;
+            beta = delta < AspirationMaxWindow ? score + delta : numeric_limits<int32_t>::max();
+        } else {
+            best_move = root_moves[line].move;
+            return score;
+        }
+        delta *= 2;
+    }
+}
 
-    move_list& moves = pool.init_list(real_depth);
-    chess_move_generator::generate_all_moves(moves, state, color > 0 ? chess::White : chess::Black, false);
+/**
+ * Alpha-beta search of one node, specialised for its type at compile time. The root searches the root moves 
+ * from root_line on, in the order left by the previous search: every root move records its score and the nodes 
+ * spent under it, and the moves that raised alpha are moved to the front for the next search. PV nodes search 
+ * the first move with the full window and the rest with a zero window, re-searching the ones that raise alpha.
+ * NonPV nodes have a zero window at beta, so they only tell whether the score reaches it: they return beta or
+ * beta - 1, and only they are pruned.
+ */
+template <dynamic_evaluator::node_type Node>
+int32_t dynamic_evaluator::search(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                  int depth, int real_depth, int32_t alpha, int32_t beta, int color, 
+                                  bool allow_null_move) {
+    constexpr bool is_root = Node == node_type::Root;
+    constexpr bool is_pv = Node != node_type::NonPV;
+    if constexpr (is_pv) {
+        update_seldepth(real_depth);
+        stats.increment(search_statistics::MainSearchNodes);
+    } else {
+        stats.increment(search_statistics::ZeroWindowNodes);
+    }
+    count_node();
+    if (is_stopped()) return 0;
+    if constexpr (is_root) {
+        line_keys[root_ply] = state.hash.value;
+    } else {
+        if (is_draw(state, real_depth)) {
+            if constexpr (is_pv) return 0;
+            return 0 >= beta ? beta : beta - 1;
+        }
+        if (real_depth >= MaxLineDepth) {
+            int32_t score = color * static_evaluator::evaluate(state);
+            if constexpr (is_pv) return score;
+            return score >= beta ? beta : beta - 1;
+        }
+        // mate distance pruning: a mate found closer to the root can't be improved here
+        if constexpr (is_pv) {
+            alpha = max(alpha, -(chess::MateScore - real_depth));
+            beta = min(beta, chess::MateScore - real_depth - 1);
+            if (alpha >= beta) return alpha;
+        } else {
+            if (-(chess::MateScore - real_depth) >= beta) return beta;
+            if (chess::MateScore - real_depth - 1 < beta) return beta - 1;
+        }
+        if (depth == 0) return nega_max_captures(state, table, real_depth, alpha, beta, color);
+    }
 
-    chess_move hash_move = table.try_get_best_move(state);
-    sort_moves(moves, state, color == 1 ? chess::White : chess::Black, hash_move, ktable, real_depth);
+    // the search without the excluded move is a different node: the table entry, pruning and null move don't apply
+    auto& frame = stack[real_depth];
+    chess_move excluded_move = move::Invalid;
+    if constexpr (!is_pv) excluded_move = frame.excluded_move;
+    bool is_excluded = move::is_valid(excluded_move);
+    transposition_table::probe_result entry{};
+    entry.best_move = move::Invalid;
+    if constexpr (!is_root) {
+        entry = table.probe(state, real_depth);
+        if (!is_excluded && is_table_cutoff(entry, depth, alpha, beta)) {
+            stats.increment(search_statistics::TranspositionCutoffs);
+            if constexpr (is_pv) return entry.score;
+            return entry.score >= beta ? beta : beta - 1;
+        }
+    }
+    
+    bool in_check = state.is_check();
+    bool is_frontier = false;
+    int32_t static_eval = -Infinity;
+    if constexpr (!is_root) {
+        // the search without the excluded move reuses the evaluation of the node that started it
+        if (!in_check && !is_excluded) frame.static_eval = color * static_evaluator::evaluate(state);
+        if (!in_check) static_eval = frame.static_eval;
+    }
+    if constexpr (!is_pv) {
+        is_frontier = depth <= FrontierMaxDepth && !in_check && !is_excluded && abs(beta) < chess::MateThreshold;
+    }
+    if constexpr (!is_pv && search_features::ReverseFutilityPruning) {
+        if (is_frontier && static_eval - ReverseFutilityMargins[depth] >= beta) {
+            // static null move: the position is so good that even a bad move keeps it above beta
+            stats.increment(search_statistics::ReverseFutilityCutoffs);
+            return beta;
+        }
+    }
+    if constexpr (!is_pv && search_features::Razoring) {
+        if (is_frontier && razoring_cutoff(state, table, depth, real_depth, beta, static_eval, color)) return beta - 1;
+    }
+    if constexpr (!is_root && search_features::NullMove) {
+        if (allow_null_move && !in_check && !is_excluded &&
+            null_move_cutoff(state, table, depth, real_depth, beta, static_eval, color)) {
+            return beta;
+        }
+    }
+    if constexpr (!is_pv && search_features::ProbCut) {
+        if (!in_check && !is_excluded && 
+            probcut_cutoff(state, table, entry.best_move, depth, real_depth, beta, static_eval, color)) {
+            return beta;
+        }
+    }
+    if constexpr (is_pv && !is_root && search_features::InternalDeepening) {
+        if (!move::is_valid(entry.best_move) && depth >= InternalDeepeningMinDepth) {
+            // internal iterative deepening: a reduced search leaves its best move in the table for this one
+            stats.increment(search_statistics::InternalDeepenings);
+            search<node_type::PV>(state, table, depth - InternalDeepeningReduction, real_depth, alpha, beta, color);
+            if (is_stopped()) return 0;
+            entry = table.probe(state, real_depth);
+        }
+    }
 
-    Stat(if (move::is_valid(hash_move)) {
-        transposition_found++;
-    })
+    chess_move hash_move = is_excluded ? move::Invalid : entry.best_move;
+    // the singular search reuses the frame of this ply, so it runs before the picker is created
+    bool is_hash_move_singular = false;
+    if constexpr (!is_root && search_features::SingularExtensions) {
+        is_hash_move_singular = !is_excluded && is_singular(state, table, entry, depth, real_depth, color);
+    }
+    chess_move previous_move = stack[real_depth - 1].current_move;
+    // the root takes its moves from the root move list instead of the picker
+    optional<move_picker> picker;
+    if constexpr (is_root) {
+        for (size_t i = root_line; i < root_moves.size(); i++) {
+            root_moves[i].score = -Infinity;
+        }
+    } else {
+        picker.emplace(frame, state, hash_move, history, history.get_countermove(state.side, previous_move));
+    }
+    if constexpr (is_pv) {
+        if (move::is_valid(hash_move)) stats.increment(search_statistics::TranspositionFound);
+    }
     
-    ktable.clear(real_depth + 1);
+    stack[real_depth + 1].killers.clear();
+    // quiet moves can't raise a hopeless frontier node above beta, they're skipped after the first move
+    bool is_futile = false;
+    if constexpr (!is_pv && search_features::FutilityPruning) {
+        is_futile = is_frontier && static_eval + FutilityMargins[depth] < beta;
+    }
+    int32_t original_alpha = alpha;
     int32_t best_score = -numeric_limits<int32_t>::max();
-    int best_index = -1;
+    chess_move node_best_move = move::Invalid;
     bool search_pv = true;
-    for (int i = 0; i < moves.size(); i++) {
-        Assert(indices[real_depth][i] < moves.size())
-        const auto& move = moves[indices[real_depth][i]];
-        game_state new_state(state);
-        new_state.apply_move(move);
-        int new_depth = new_state.is_check() ? depth : depth - 1;
-        int32_t score;
-        if (search_pv) {
-            score = -pvs(new_state, table, ktable, new_depth, real_depth + 1, -beta, -alpha, -color);
+    int move_count = 0;
+    array<chess_move, history_table::MaxSearchedMoves> searched_quiets;
+    array<chess_move, history_table::MaxSearchedMoves> searched_captures;
+    size_t quiets_count = 0, captures_count = 0;
+    for (int i = 0;; i++) {
+        chess_move move;
+        if constexpr (is_root) {
+            if (root_line + i >= root_moves.size()) break;
+            move = root_moves[root_line + i].move;
         } else {
-            score = -zero_window_search(new_state, table, ktable, new_depth, real_depth + 1, -alpha, -color);
-            if (alpha < score) {
-                Stat(pvs_research_count++;)
-                score = -pvs(new_state, table, ktable, new_depth, real_depth + 1, -beta, -alpha, -color);
+            move = picker->next();
+            if (!move::is_valid(move)) break;
+            if (move == excluded_move) {
+                i--; // the excluded move doesn't take a place in the move order
+                continue;
+            }
+        }
+        move_count++;
+        uint64_t nodes_before = 0;
+        if constexpr (is_root) nodes_before = nodes.load(memory_order_relaxed);
+        auto undo = state.apply_move(move);
+        frame.current_move = move;
+        bool gives_check = state.is_check();
+        if constexpr (!is_pv) {
+            if (is_futile && i > 0 && !gives_check && move::is_quiet(move)) {
+                stats.increment(search_statistics::FutilityPrunedMoves);
+                state.unmake_move(move, undo);
+                continue;
+            }
+        }
+        bool is_singular_move = is_hash_move_singular && move == hash_move;
+        if (is_singular_move) stats.increment(search_statistics::SingularExtendedMoves);
+        int extension = is_singular_move ? OnePly 
+                      : search_features::CheckExtensions && gives_check && is_safe_check(state, move, undo) ? CheckExtension 
+                      : 0;
+        int new_depth = depth - 1 + extend(real_depth, extension);
+        int reduction = late_move_reduction(depth, i, in_check || gives_check, move, frame.killers);
+        int32_t score;
+        if constexpr (is_pv) {
+            if (search_pv) {
+                score = -search<node_type::PV>(state, table, new_depth, real_depth + 1, -beta, -alpha, -color);
+            } else {
+                // reductions are smaller on the principal variation
+                score = late_move_search(state, table, new_depth, max(0, reduction - 1), real_depth, alpha, color);
+                if (alpha < score) {
+                    stats.increment(search_statistics::PvsResearches);
+                    score = -search<node_type::PV>(state, table, new_depth, real_depth + 1, -beta, -alpha, -color);
+                }
             }
+        } else {
+            score = late_move_search(state, table, new_depth, reduction, real_depth, alpha, color);
         }
+        state.unmake_move(move, undo);
+        if constexpr (is_root) root_moves[root_line + i].nodes += nodes.load(memory_order_relaxed) - nodes_before;
+        if (is_stopped()) return 0;
         if (score > best_score) {
             best_score = score;
-            best_index = indices[real_depth][i];
+            node_best_move = move;
         }
         if (score > alpha) {
+            if constexpr (is_root) root_moves[root_line + i].score = score;
             search_pv = false;
         }
         alpha = max(alpha, score);
         if (alpha >= beta) {
-            ktable.add_killer(real_depth, move);
+            stats.increment(search_statistics::BetaCutoffs);
+            if (i == 0) stats.increment(search_statistics::FirstMoveCutoffs);
+            if constexpr (!is_root) {
+                if (move::is_quiet(move)) frame.killers.add(move);
+                history.add_cutoff(state.side, move, previous_move, depth, span(searched_quiets.data(), quiets_count),
+                                   span(searched_captures.data(), captures_count));
+            }
             break;
         }
+        if (move::is_quiet(move)) {
+            if (quiets_count < searched_quiets.size()) searched_quiets[quiets_count++] = move;
+        } else {
+            if (captures_count < searched_captures.size()) searched_captures[captures_count++] = move;
+        }
     }
 
-    if (best_index >= 0) {
-        Stat(if (move::is_valid(hash_move) && moves[best_index] == hash_move) {
-            transposition_best_hit++;
-        })
-        table.add(state, depth, moves[best_index], true);
-        if (best_move != nullptr) {
-            *best_move = chess_move(moves[best_index]);
+    if constexpr (!is_pv) {
+        if (best_score >= beta) {
+            if (!is_excluded) table.add(state, depth, real_depth, beta, transposition_table::bound::Lower, node_best_move, false);
+            return beta;
         }
+        if (is_excluded) return beta - 1; // the excluded move may have been the only one
+        if (move_count == 0) {
+            int32_t score = in_check ? -(chess::MateScore - real_depth) : 0;
+            return score >= beta ? beta : beta - 1;
+        }
+        table.add(state, depth, real_depth, beta - 1, transposition_table::bound::Upper, move::Invalid, false);
+        return beta - 1;
     }
 
+    if (move_count == 0) {
+        best_score = in_check ? -(chess::MateScore - real_depth) : 0;
+    }
+    if constexpr (is_root) {
+        if (best_score > original_alpha) {
+            // moves that raised alpha go first, the ones that failed low keep their order: sorting them by the nodes 
+            // spent on them made the search larger; after a fail low the order is kept, so the re-search starts 
+            // with the same move
+            stable_sort(root_moves.begin() + static_cast<ptrdiff_t>(root_line), root_moves.end(), 
+                        [](const root_move& a, const root_move& b) { return a.score > b.score; });
+        }
+        // the lines after the first one are searched without some of the moves, so they aren't the root score
+        if (root_line > 0) return best_score;
+    }
+    auto bound_type = best_score >= beta ? transposition_table::bound::Lower
+                    : best_score > original_alpha ? transposition_table::bound::Exact
+                    : transposition_table::bound::Upper;
+    table.add(state, depth, real_depth, best_score, bound_type, node_best_move, true);
+    if constexpr (!is_root) {
+        if (move::is_valid(node_best_move) && node_best_move == hash_move) {
+            stats.increment(search_statistics::TranspositionBestHit);
+        }
+    }
     return best_score;
 }
 
-int32_t dynamic_evaluator::zero_window_search(const game_state& state, transposition_table& table, killer_table& ktable, // NOLINT(misc-no-recursion) 
-                                              int depth, int real_depth, int32_t beta, int color) {
-    Stat(zero_window_nodes++;)
-    Assert(real_depth < MaxDepth)
-    if (depth == 0) return nega_max_captures(state, real_depth, beta - 1, beta, color);
+/**
+ * Zero window search of a move just made at this node, reduced by a late move reduction.
+ * A reduced search that beats alpha is repeated at the full depth.
+ */
+int32_t dynamic_evaluator::late_move_search(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                            int new_depth, int reduction, int real_depth, int32_t alpha, int color) {
+    int32_t score = -search<node_type::NonPV>(state, table, new_depth - reduction, real_depth + 1, -alpha - 1, -alpha, -color);
+    if (reduction > 0 && alpha < score) {
+        stats.increment(search_statistics::LateMoveResearches);
+        score = -search<node_type::NonPV>(state, table, new_depth, real_depth + 1, -alpha - 1, -alpha, -color);
+    }
+    return score;
+}
 
-    move_list& moves = pool.init_list(real_depth);
-    chess_move_generator::generate_all_moves(moves, state, color > 0 ? chess::White : chess::Black, false);
+bool dynamic_evaluator::is_draw(const game_state& state, int real_depth) {
+    size_t ply = root_ply + real_depth - 1;
+    line_keys[ply] = state.hash.value;
+    if (state.halfmove_clock >= 100) return true;
+    // a repetition has the same side to move and can't reach past the last capture, pawn move or null move,
+    // a single repetition inside the search is scored as a draw
+    size_t distance = min<size_t>(state.halfmove_clock, ply - last_null_ply);
+    for (size_t back = 4; back <= distance; back += 2) {
+        if (line_keys[ply - back] == state.hash.value) return true;
+    }
+    return false;
+}
 
-    chess_move hash_move = table.try_get_best_move(state);
-    sort_moves(moves, state, color == 1 ? chess::White : chess::Black, hash_move, ktable, real_depth);
-    
-    ktable.clear(real_depth + 1);
-    for (int i = 0; i < moves.size(); i++) {
-        Assert(indices[real_depth][i] < moves.size())
-        const auto& move = moves[indices[real_depth][i]];
-        game_state new_state(state);
-        new_state.apply_move(move);
-        int new_depth = new_state.is_check() ? depth : depth - 1;
-        int32_t score = -zero_window_search(new_state, table, ktable, new_depth, real_depth + 1, 1 - beta, -color);
-        if (score >= beta) {
-            table.add(state, depth, move, false);
-            ktable.add_killer(real_depth, move);
-            return beta;
+bool dynamic_evaluator::null_move_cutoff(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                         int depth, int real_depth, int32_t beta, int32_t static_eval, int color) {
+    // passing the move is unsafe in check (checked by the caller) and in pawn endgames, where zugzwang is common
+    uint8_t side = color > 0 ? chess::White : chess::Black;
+    if (depth < NullMoveMinDepth || abs(beta) >= chess::MateThreshold || 
+        !state.has_non_pawn_material(side)) return false;
+    if (static_eval < beta) return false;
+
+    int reduction = depth >= 7 ? 3 : 2;
+    auto undo = state.apply_null_move();
+    stack[real_depth].current_move = move::Invalid;
+    stack[real_depth + 1].extension = stack[real_depth].extension;
+    // repetitions can't be looked up across the passed move
+    size_t previous_null_ply = last_null_ply;
+    last_null_ply = root_ply + real_depth;
+    int32_t score = -search<node_type::NonPV>(state, table, max(0, depth - 1 - reduction), real_depth + 1, 
+                                              -beta, 1 - beta, -color, false);
+    last_null_ply = previous_null_ply;
+    state.unmake_null_move(undo);
+    if (is_stopped() || score < beta) return false;
+    if (depth >= NullMoveVerificationDepth) {
+        // deep cutoffs are verified by a reduced search of the node itself without null move
+        score = search<node_type::NonPV>(state, table, depth - reduction, real_depth, beta - 1, beta, color, false);
+        if (is_stopped() || score < beta) return false;
+    }
+    stats.increment(search_statistics::NullMoveCutoffs);
+    return true;
+}
+
+/**
+ * Whole plies the move at this ply is extended by, given its extension in fractions of a ply.
+ * The fractions add up along the line, and no line is extended by more plies than the root depth,
+ * so perpetual checks can't run the search away.
+ */
+int dynamic_evaluator::extend(int real_depth, int units) {
+    int used = stack[real_depth].extension;
+    int total = max(used, min(used + units, root_depth * OnePly));
+    stack[real_depth + 1].extension = total;
+    return total / OnePly - used / OnePly;
+}
+
+/**
+ * A check is safe when the move doesn't lose material by SEE, which is evaluated in the position before the move.
+ */
+bool dynamic_evaluator::is_safe_check(game_state& state, const chess_move& move, undo_info& undo) {
+    state.unmake_move(move, undo);
+    bool result = static_evaluator::static_exchange(state, move) >= 0;
+    undo = state.apply_move(move);
+    return result;
+}
+
+void dynamic_evaluator::update_seldepth(int real_depth) {
+    seldepth = max(seldepth, real_depth);
+    stats.update_max_depth(real_depth);
+}
+
+/**
+ * ProbCut: a good capture that beats beta by a margin in a much shallower search would most likely 
+ * beat beta in the full depth search as well.
+ */
+bool dynamic_evaluator::probcut_cutoff(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                       const chess_move& hash_move, int depth, int real_depth, int32_t beta, 
+                                       int32_t static_eval, int color) {
+    if (depth < ProbCutMinDepth || abs(beta) >= chess::MateThreshold) return false;
+    int32_t probcut_beta = beta + probcut_margin;
+    int probcut_depth = max(0, depth - 1 - probcut_reduction);
+    // the frame of this ply is reused, so this runs before the picker of the node is created;
+    // captures losing material are not returned by the picker in this mode
+    auto& frame = stack[real_depth];
+    move_picker picker(frame, state, hash_move, history, move::Invalid, true);
+    for (chess_move move = picker.next(); move::is_valid(move); move = picker.next()) {
+        // only a capture that wins enough material by itself is expected to hold the raised beta
+        if (static_eval + static_evaluator::static_exchange(state, move) < probcut_beta) continue;
+        auto undo = state.apply_move(move);
+        frame.current_move = move;
+        stack[real_depth + 1].extension = frame.extension;
+        // quiescence search filters out the captures that don't hold up before the costlier one
+        int32_t score = -nega_max_captures(state, table, real_depth + 1, -probcut_beta, 1 - probcut_beta, -color);
+        if (score >= probcut_beta && probcut_depth > 0) {
+            score = -search<node_type::NonPV>(state, table, probcut_depth, real_depth + 1, 
+                                              -probcut_beta, 1 - probcut_beta, -color);
+        }
+        state.unmake_move(move, undo);
+        if (is_stopped()) return false;
+        if (score >= probcut_beta) {
+            stats.increment(search_statistics::ProbCutCutoffs);
+            return true;
         }
     }
-    
-    return beta - 1;
+    return false;
+}
+
+bool dynamic_evaluator::is_singular(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                    const transposition_table::probe_result& entry, int depth, int real_depth, int color) {
+    // the hash move is singular when a reduced search of all other moves fails low against a bound below its score
+    if (!search_features::SingularExtensions || !singular_extensions || depth < SingularMinDepth || !entry.found || entry.depth < depth - SingularEntryDepth ||
+        (entry.bound_type != transposition_table::bound::Lower && entry.bound_type != transposition_table::bound::Exact) ||
+        abs(entry.score) >= chess::MateThreshold || !chess_move_generator::is_valid_move(entry.best_move, state)) return false;
+    int32_t singular_beta = entry.score - SingularMargin * depth;
+    auto& frame = stack[real_depth];
+    frame.excluded_move = entry.best_move;
+    int32_t score = search<node_type::NonPV>(state, table, (depth - 1) / 2, real_depth, 
+                                             singular_beta - 1, singular_beta, color, false);
+    frame.excluded_move = move::Invalid;
+    return !is_stopped() && score < singular_beta;
+}
+
+bool dynamic_evaluator::razoring_cutoff(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                        int depth, int real_depth, int32_t beta, int32_t static_eval, int color) {
+    // far below beta only captures can save the node, so quiescence search decides
+    if (static_eval + RazoringMargins[depth] >= beta) return false;
+    int32_t score = nega_max_captures(state, table, real_depth, beta - 1, beta, color);
+    if (is_stopped() || score >= beta) return false;
+    stats.increment(search_statistics::RazoringCutoffs);
+    return true;
 }
 
-int32_t dynamic_evaluator::nega_max_captures(const game_state& state, int real_depth, int32_t alpha, int32_t beta, int color) { // NOLINT(misc-no-recursion)
-    Stat(max_depth = max(max_depth, real_depth);)
-    Stat(capture_search_nodes++;)
-    Assert(real_depth < MaxDepth)
-    int32_t evaluation = color * static_evaluator::evaluate(state);
-    alpha = max(alpha, evaluation);
+int32_t dynamic_evaluator::nega_max_captures(game_state& state, transposition_table& table, // NOLINT(misc-no-recursion)
+                                             int real_depth, int32_t alpha, int32_t beta, int color) {
+    update_seldepth(real_depth);
+    stats.increment(search_statistics::CaptureSearchNodes);
+    count_node();
+    if (real_depth >= MaxLineDepth) return clamp(color * static_evaluator::evaluate(state), alpha, beta);
+    auto entry = table.probe(state, real_depth);
+    if (is_table_cutoff(entry, 0, alpha, beta)) {
+        stats.increment(search_statistics::TranspositionCutoffs);
+        return clamp(entry.score, alpha, beta);
+    }
+    
+    int32_t original_alpha = alpha;
+    int32_t stand_pat = color * static_evaluator::evaluate(state);
+    alpha = max(alpha, stand_pat);
     if (alpha >= beta) return beta;
     
-    move_list& moves = pool.init_list(real_depth);
-    uint8_t side = color > 0 ? chess::White : chess::Black;
-    chess_move_generator::generate_all_moves(moves, state, side, true);
-    sort_moves(moves, state, side, move::Invalid, killer_table::Empty, real_depth);
-
-    for (int i = 0; i < moves.size(); i++) {
-        Assert(indices[real_depth][i] < moves.size())
-        const auto& move = moves[indices[real_depth][i]];
+    // losing captures and killers are not returned by the picker in this mode
+    move_picker picker(stack[real_depth], state, entry.best_move, history, move::Invalid, true);
+    for (chess_move move = picker.next(); move::is_valid(move); move = picker.next()) {
         Assert(state.is_capture(move))
-        game_state new_state(state);
-        new_state.apply_move(move);
-        evaluation = -nega_max_captures(new_state, real_depth + 1, -beta, -alpha, -color);
+        auto captured = move::defender(move) == chess::EmptyPiece ? chess::Pawn : move::defender(move);
+        if (search_features::DeltaPruning && move::flag(move) < move::move_flag::PromoteToKnight && 
+            stand_pat + static_evaluator::material_cost[captured] + DeltaMargin <= alpha) {
+            // delta pruning: even winning the piece for free doesn't raise the score to alpha
+            stats.increment(search_statistics::DeltaPrunedMoves);
+            continue;
+        }
+        auto undo = state.apply_move(move);
+        int32_t evaluation = -nega_max_captures(state, table, real_depth + 1, -beta, -alpha, -color);
+        state.unmake_move(move, undo);
         alpha = max(alpha, evaluation);
-        if (alpha >= beta) return beta;
+        if (alpha >= beta) {
+            table.add(state, 0, real_depth, beta, transposition_table::bound::Lower, move, false);
+            return beta;
+        }
     }
 
+    auto bound_type = alpha > original_alpha ? transposition_table::bound::Exact : transposition_table::bound::Upper;
+    table.add(state, 0, real_depth, alpha, bound_type, move::Invalid, false);
     return alpha;
 }
\ No newline at end of file
@@ -5,40 +5,156 @@
 #include "game_state.h"
 #include "transposition_table.h"
 #include "move_list.h"
-#include "move_list_pool.h"
-#include "killer_table.h"
+#include "search_stack.h"
+#include "search_features.h"
+#include "history_table.h"
 #include "chess_utils.h"
+#include "search_limits.h"
+#include "time_manager.h"
+#include "search_statistics.h"
 #include <vector>
+#include <atomic>
+#include <memory>
+#include <functional>
+
+struct search_info {
+    int depth;
+    int seldepth; // the deepest ply reached by the main thread in this iteration
+    int32_t score;
+    uint64_t nodes;
+    std::chrono::milliseconds time;
+    chess_move best_move;
+    size_t multi_pv; // 1-based index of the line
+};
+
+// Root move with its statistics in the current iteration, the root moves are kept in the order of the last search
+struct root_move {
+    chess_move move;
+    int32_t score; // of the last root search, -Infinity when the move failed low or wasn't searched
+    uint64_t nodes; // spent under the move in the current iteration
+};
 
 class dynamic_evaluator {
+    // Root searches the root move list, PV nodes have an open window, NonPV nodes a zero window
+    enum class node_type : uint8_t { Root, PV, NonPV };
+
     static constexpr int Infinity = 1000000000;
-    static constexpr size_t MaxDepth = 500;
+    static constexpr int MaxSearchDepth = 100;
+    // a node reads the frame of the next ply, deeper nodes return the static evaluation
+    static constexpr int MaxLineDepth = static_cast<int>(search_stack::MaxPly) - 2;
+    static constexpr uint64_t LimitsCheckInterval = 2048; // nodes between checks of the clock and stop flag
+    static constexpr int AspirationMinDepth = 3;
+    static constexpr int32_t AspirationWindow = 50;
+    static constexpr int32_t AspirationMaxWindow = 1000;
+    static constexpr int NullMoveMinDepth = 2;
+    static constexpr int NullMoveVerificationDepth = 8;
+    static constexpr int LateMoveMinDepth = 3;
+    static constexpr int LateMoveMinIndex = 3;
+    static constexpr size_t LateMoveTableSize = 64;
+    static const std::array<std::array<int, LateMoveTableSize>, LateMoveTableSize> late_move_reductions;
+    static constexpr int FrontierMaxDepth = 3; // futility pruning and razoring are applied at depth 1..FrontierMaxDepth
+    static constexpr std::array<int32_t, FrontierMaxDepth + 1> ReverseFutilityMargins = {0, 120, 240, 360};
+    static constexpr std::array<int32_t, FrontierMaxDepth + 1> FutilityMargins = {0, 150, 300, 500};
+    static constexpr std::array<int32_t, FrontierMaxDepth + 1> RazoringMargins = {0, 300, 450, 600};
+    static constexpr int32_t DeltaMargin = 200; // positional gain a capture can bring in quiescence search
+    static constexpr int SingularMinDepth = 8;
+    static constexpr int SingularEntryDepth = 3; // how much shallower than the node the table entry may be
+    static constexpr int32_t SingularMargin = 2; // per ply of depth, below the table score
+    static constexpr int InternalDeepeningMinDepth = 5; // PV nodes without a hash move get a shallower search first
+    static constexpr int InternalDeepeningReduction = 2;
+    static constexpr int ProbCutMinDepth = 8;
+    static constexpr int OnePly = 4; // extensions are accumulated along the line in fractions of a ply
+    static constexpr int CheckExtension = 3;
 
-    move_list_pool pool;
-    std::array<int, chess::MaxLegalMoves> evaluations;
-    std::array<std::array<int, chess::MaxLegalMoves>, MaxDepth> indices;
+    // Search context that lives across searches: the table and the statistics of previous moves are reused
+    std::unique_ptr<transposition_table> table; // owned by the main searcher and shared with the helpers
+    search_stack stack; // per-ply frames of the current line, the killers are kept between searches
+    history_table history;
+    int root_depth; // of the running iteration, bounds the extensions of a line
+    int seldepth;
+    std::vector<uint64_t> line_keys; // keys of the game history followed by the keys of the current line
+    size_t root_ply;
+    size_t last_null_ply; // repetitions are looked up only after this ply
+    std::vector<root_move> root_moves; // the lines of the multi-PV search come first
+    size_t root_line; // first root move searched by the root node, the moves before it are the previous lines
+    int32_t threads;
+    // changed only while no search runs, so statistics() can walk them during a search
+    std::vector<std::unique_ptr<dynamic_evaluator>> helpers;
+    std::atomic<bool> stop_requested;
+    std::atomic<bool> ponderhit_requested;
+    const std::atomic<bool>* stop_flag;
+    bool stopped;
+    uint64_t next_limits_check;
+    search_limits limits;
+    uint8_t root_side;
+    time_manager timer;
+    search_counters stats; // of this thread during the last search
+    
+    void init_helpers();
+    void init_line_keys();
+    bool is_draw(const game_state& state, int real_depth);
+    void count_node();
+    void check_limits();
+    [[nodiscard]] uint64_t searched_nodes() const;
+    chess_move find_ponder_move(const game_state& state, const chess_move& best_move);
     
-    int32_t pvs(const game_state& state, transposition_table& table, killer_table& ktable,
-                int depth, int real_depth, int32_t alpha, int32_t beta, int color,
-                chess_move* best_move = nullptr);
-    int32_t zero_window_search(const game_state& state, transposition_table& table, killer_table& ktable, 
-                               int depth, int real_depth, int32_t beta, int color);
-    int32_t nega_max_captures(const game_state& state,  
+    void iterative_deepening(const game_state& state, transposition_table& table,
+                             int from_depth, int to_depth, chess_move& best_move);
+    void init_root_moves(const game_state& root, transposition_table& table);
+    int32_t aspiration_search(game_state& root, transposition_table& table,
+                              int depth, bool use_window, int32_t score, int color, size_t line, chess_move& best_move);
+    template <node_type Node>
+    int32_t search(game_state& state, transposition_table& table, int depth, int real_depth, 
+                   int32_t alpha, int32_t beta, int color, bool allow_null_move = true);
+    int32_t late_move_search(game_state& state, transposition_table& table,
+                             int new_depth, int reduction, int real_depth, int32_t alpha, int color);
+    bool null_move_cutoff(game_state& state, transposition_table& table,
+                          int depth, int real_depth, int32_t beta, int32_t static_eval, int color);
+    int extend(int real_depth, int units);
+    static bool is_safe_check(game_state& state, const chess_move& move, undo_info& undo);
+    void update_seldepth(int real_depth);
+    bool probcut_cutoff(game_state& state, transposition_table& table,
+                        const chess_move& hash_move, int depth, int real_depth, int32_t beta, 
+                        int32_t static_eval, int color);
+    bool is_singular(game_state& state, transposition_table& table,
+                     const transposition_table::probe_result& entry, int depth, int real_depth, int color);
+    bool razoring_cutoff(game_state& state, transposition_table& table,
+                         int depth, int real_depth, int32_t beta, int32_t static_eval, int color);
+    int32_t nega_max_captures(game_state& state, transposition_table& table,
                               int real_depth, int32_t alpha, int32_t beta, int color);
-    void sort_moves(move_list &moves, const game_state &state, uint8_t side,
-                    const chess_move &hash_move, const killer_table &ktable, int real_depth);
-    static int32_t eval_move(const chess_move& move, const game_state& state, bitboard pawn_capture_mask, bool is_killer);
+    static int late_move_reduction(int depth, int move_index, bool is_check, const chess_move& move,
+                                   const killer_moves& killers);
+    static bool is_table_cutoff(const transposition_table::probe_result& entry, int depth, int32_t alpha, int32_t beta);
+    bool is_stopped();
 public:
-    int32_t max_depth;
-    int32_t main_search_nodes;
-    int32_t zero_window_nodes;
-    int32_t capture_search_nodes;
-    int32_t transposition_found;
-    int32_t transposition_best_hit;
-    int32_t pvs_research_count;
+    static constexpr int32_t DefaultProbCutMargin = 200;
+    static constexpr int DefaultProbCutReduction = 4;
+
+    size_t hash_size_mb;
+    bool singular_extensions; // extend the hash move when no other move comes close to its score
+    int32_t probcut_margin; // how far above beta a good capture must score in the reduced search to cut the node
+    int probcut_reduction; // depth reduction of that search
+    size_t multi_pv; // number of best lines searched at the root
+    std::atomic<uint64_t> nodes;
+    uint64_t total_nodes; // nodes of all search threads during the last find_best_move
+    std::function<void(const search_info&)> info_callback; // called by the main thread after every iteration
+    std::vector<uint64_t> game_history; // keys of the positions played before the root, the oldest first
+    chess_move ponder_move; // expected reply to the last best move, move::Invalid when unknown
     chess_move find_best_move(const game_state& state, int depth);
+    chess_move find_best_move(const game_state& state, const search_limits& limits);
+    void stop();
+    void ponderhit(); // the expected move was played, the pondering search switches to the clock limits
+    void clear_stop(); // must be called before the next search after stop() or ponderhit()
+    [[nodiscard]] bool is_stop_requested() const;
+    [[nodiscard]] bool is_ponderhit_requested() const;
+    [[nodiscard]] search_statistics statistics() const; // of the last or running search, over all threads
+    [[nodiscard]] const std::vector<root_move>& get_root_moves() const; // of the main thread after the search
+    void set_threads(int32_t threads);
+    void set_hash_size(size_t size_mb);
+    void new_game(); // forgets everything learned in the previous games
     
-    dynamic_evaluator();
+    // a searcher with hash_size_mb = 0 has no table of its own, helpers are created this way
+    explicit dynamic_evaluator(int threads = 1, size_t hash_size_mb = transposition_table::DefaultSizeMb);
     
     friend class debug_tools;
 };
@@ -108,7 +108,35 @@ void game_state::update_bitboards() {
     empty = ~all;
 }
 
-void game_state::apply_move(const chess_move& move) {
+void game_state::update_occupancy() {
+    // side boards are updated incrementally by the piece operations
+    inv_side_board[White] = ~side_board[White];
+    inv_side_board[Black] = ~side_board[Black];
+    all = side_board[White] | side_board[Black];
+    empty = ~all;
+}
+
+undo_info game_state::get_undo_info() const {
+    uint8_t packed_castling = castling[White][Queen] | castling[White][King] << 1 | 
+                              castling[Black][Queen] << 2 | castling[Black][King] << 3 | 
+                              castling_happened[White] << 4 | castling_happened[Black] << 5;
+    return undo_info {hash, halfmove_clock, en_passant, packed_castling};
+}
+
+void game_state::restore(const undo_info& undo) {
+    hash = undo.hash;
+    halfmove_clock = undo.halfmove_clock;
+    en_passant = undo.en_passant;
+    castling[White][Queen] = undo.castling & 1;
+    castling[White][King] = undo.castling >> 1 & 1;
+    castling[Black][Queen] = undo.castling >> 2 & 1;
+    castling[Black][King] = undo.castling >> 3 & 1;
+    castling_happened[White] = undo.castling >> 4 & 1;
+    castling_happened[Black] = undo.castling >> 5 & 1;
+}
+
+undo_info game_state::apply_move(const chess_move& move) {
+    undo_info undo = get_undo_info();
     remove_piece(move::from(move), side, move::attacker(move));
     add_piece(move::to(move), side, move::attacker(move));
     if (move::defender(move) != EmptyPiece) {
@@ -165,7 +193,7 @@ void game_state::apply_move(const chess_move& move) {
             break;
         default: Assert(false)
     }
-    update_bitboards();
+    update_occupancy();
     if (move::flag(move) != move::move_flag::PawnLongMove) {
         en_passant = chess::Empty;
     }
@@ -193,6 +221,82 @@ void game_state::apply_move(const chess_move& move) {
         halfmove_clock++;
     }
     invert_side();
+    return undo;
+}
+
+void game_state::unmake_move(const chess_move& move, const undo_info& undo) {
+    side = inverse_color(side);
+    if (side == Black) {
+        fullmove_number--;
+    }
+    auto from = move::from(move);
+    auto to = move::to(move);
+    switch (move::flag(move)) {
+        case move::move_flag::EnPassantCapture:
+            toggle_piece(side == White ? to - 8 : to + 8, inverse_color(side), Pawn);
+            break;
+        case move::move_flag::WhiteLongCastling:
+            toggle_piece(3, White, Rook);
+            toggle_piece(0, White, Rook);
+            break;
+        case move::move_flag::WhiteShortCastling:
+            toggle_piece(5, White, Rook);
+            toggle_piece(7, White, Rook);
+            break;
+        case move::move_flag::BlackLongCastling:
+            toggle_piece(59, Black, Rook);
+            toggle_piece(56, Black, Rook);
+            break;
+        case move::move_flag::BlackShortCastling:
+            toggle_piece(61, Black, Rook);
+            toggle_piece(63, Black, Rook);
+            break;
+        case move::move_flag::PromoteToRook:
+            toggle_piece(to, side, Rook);
+            toggle_piece(to, side, Pawn);
+            break;
+        case move::move_flag::PromoteToQueen:
+            toggle_piece(to, side, Queen);
+            toggle_piece(to, side, Pawn);
+            break;
+        case move::move_flag::PromoteToKnight:
+            toggle_piece(to, side, Knight);
+            toggle_piece(to, side, Pawn);
+            break;
+        case move::move_flag::PromoteToBishop:
+            toggle_piece(to, side, Bishop);
+            toggle_piece(to, side, Pawn);
+            break;
+        default:
+            break;
+    }
+    toggle_piece(to, side, move::attacker(move));
+    toggle_piece(from, side, move::attacker(move));
+    if (move::defender(move) != EmptyPiece) {
+        toggle_piece(to, inverse_color(side), move::defender(move));
+    }
+    update_occupancy();
+    restore(undo);
+}
+
+undo_info game_state::apply_null_move() {
+    undo_info undo = get_undo_info();
+    // en passant square is not a part of the hash, so only the side is inverted there
+    en_passant = chess::Empty;
+    if (side == Black) {
+        fullmove_number++;
+    }
+    halfmove_clock++;
+    invert_side();
+    return undo;
+}
+
+void game_state::unmake_null_move(const undo_info& undo) {
+    side = inverse_color(side);
+    if (side == Black) {
+        fullmove_number--;
+    }
+    restore(undo);
 }
 
 bool game_state::is_check() const {
@@ -203,15 +307,22 @@ bool game_state::is_check() const {
 void game_state::add_piece(uint8_t index, uint8_t color, uint8_t type) {
     Assert(!get_bit(board[color][type], index))
     set_1(board[color][type], index);
+    set_1(side_board[color], index);
     hash.invert_piece(index, color, type);
 }
 
 void game_state::remove_piece(uint8_t index, uint8_t color, uint8_t type) {
     Assert(get_bit(board[color][type], index))
     set_0(board[color][type], index);
+    set_0(side_board[color], index);
     hash.invert_piece(index, color, type);
 }
 
+void game_state::toggle_piece(uint8_t index, uint8_t color, uint8_t type) {
+    board[color][type] ^= 1ULL << index;
+    side_board[color] ^= 1ULL << index;
+}
+
 void game_state::break_castling(uint8_t color, uint8_t type) {
     if (castling[color][type]) {
         castling[color][type] = false;
@@ -321,3 +432,7 @@ uint8_t game_state::get_piece(uint8_t color, uint8_t position) const {
     }
     return chess::EmptyPiece;
 }
+
+bool game_state::has_non_pawn_material(uint8_t color) const {
+    return side_board[color] != (board[color][chess::King] | board[color][chess::Pawn]);
+}
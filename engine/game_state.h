@@ -7,6 +7,17 @@
 #include "chess_move.h"
 #include "zobrist_hash.h"
 
+/**
+ * Part of the state that apply_move can't restore from the move itself, returned for unmake_move.
+ * Captured piece is stored in the move.
+ */
+struct undo_info {
+    zobrist_hash hash;
+    int halfmove_clock;
+    uint8_t en_passant;
+    uint8_t castling; // [0-3 bits] castling rights, [4-5 bits] castling happened
+};
+
 struct game_state {
     std::array<std::array<bitboard, 6>, 2> board{}; // color, figure type
     std::array<bitboard, 2> side_board{};
@@ -27,14 +38,22 @@ struct game_state {
     void remove_piece(uint8_t index, uint8_t color, uint8_t type);
     void break_castling(uint8_t color, uint8_t type);
     void invert_side();
+    void toggle_piece(uint8_t index, uint8_t color, uint8_t type); // without a hash update, for unmake_move
+    void update_occupancy();
+    [[nodiscard]] undo_info get_undo_info() const;
+    void restore(const undo_info& undo);
 public:
     explicit game_state(const std::string& fen);
     game_state(const game_state& state) = default;
-    void apply_move(const chess_move& move);
+    undo_info apply_move(const chess_move& move);
+    void unmake_move(const chess_move& move, const undo_info& undo);
+    undo_info apply_null_move();
+    void unmake_null_move(const undo_info& undo);
     [[nodiscard]] uint8_t get_piece(uint8_t color, uint8_t position) const;
     [[nodiscard]] bool is_check() const;
     [[nodiscard]] std::string fen() const;
     [[nodiscard]] bool is_capture(const chess_move& move) const;
+    [[nodiscard]] bool has_non_pawn_material(uint8_t color) const;
 };
 
 
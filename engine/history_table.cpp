@@ -0,0 +1,87 @@
+#include "history_table.h"
+#include <algorithm>
+
+using namespace std;
+
+history_table::history_table() : butterfly(), capture_history(), countermoves() {
+    clear();
+}
+
+void history_table::clear() {
+    for (auto& side_table : butterfly) {
+        for (auto& from_table : side_table) {
+            from_table.fill(0);
+        }
+    }
+    for (auto& piece_table : capture_history) {
+        for (auto& to_table : piece_table) {
+            to_table.fill(0);
+        }
+    }
+    for (auto& side_table : countermoves) {
+        for (auto& piece_table : side_table) {
+            piece_table.fill(move::Invalid);
+        }
+    }
+}
+
+void history_table::age() {
+    // older iterations matter less, but keep the ordering until new cutoffs replace it
+    for (auto& side_table : butterfly) {
+        for (auto& from_table : side_table) {
+            for (auto& value : from_table) value /= 2;
+        }
+    }
+    for (auto& piece_table : capture_history) {
+        for (auto& to_table : piece_table) {
+            for (auto& value : to_table) value /= 2;
+        }
+    }
+}
+
+void history_table::update(int32_t& value, int32_t bonus) {
+    // the closer the value is to the limit, the smaller the step, so values stay in [-MaxHistory, MaxHistory]
+    value += bonus - value * abs(bonus) / MaxHistory;
+}
+
+uint8_t history_table::captured_piece(const chess_move& move) {
+    return move::flag(move) == move::move_flag::EnPassantCapture ? chess::Pawn : move::defender(move);
+}
+
+int32_t& history_table::get_capture_entry(const chess_move& move) {
+    return capture_history[move::attacker(move)][move::to(move)][captured_piece(move)];
+}
+
+void history_table::add_cutoff(uint8_t side, const chess_move& move, const chess_move& previous_move, int depth,
+                               span<const chess_move> searched_quiets, span<const chess_move> searched_captures) {
+    int32_t bonus = min(depth * depth * 32, MaxBonus);
+    if (move::is_quiet(move)) {
+        update(butterfly[side][move::from(move)][move::to(move)], bonus);
+        for (const auto& quiet : searched_quiets) {
+            update(butterfly[side][move::from(quiet)][move::to(quiet)], -bonus);
+        }
+        if (move::is_valid(previous_move)) {
+            countermoves[side][move::attacker(previous_move)][move::to(previous_move)] = move;
+        }
+    } else if (captured_piece(move) != chess::EmptyPiece) {
+        update(get_capture_entry(move), bonus);
+    }
+    // a capture that was searched first and didn't cut is worse than expected, even if a quiet move cut
+    for (const auto& capture : searched_captures) {
+        if (captured_piece(capture) != chess::EmptyPiece) update(get_capture_entry(capture), -bonus);
+    }
+}
+
+int32_t history_table::get_quiet_score(uint8_t side, const chess_move& move) const {
+    return butterfly[side][move::from(move)][move::to(move)];
+}
+
+int32_t history_table::get_capture_score(const chess_move& move) const {
+    auto captured = captured_piece(move);
+    return captured == chess::EmptyPiece ? 0 : capture_history[move::attacker(move)][move::to(move)][captured];
+}
+
+chess_move history_table::get_countermove(uint8_t side, const chess_move& previous_move) const {
+    if (!move::is_valid(previous_move)) return move::Invalid;
+    return countermoves[side][move::attacker(previous_move)][move::to(previous_move)];
+}
@@ -0,0 +1,43 @@
+#ifndef CHESSUCIENGINE_HISTORY_TABLE_H
+#define CHESSUCIENGINE_HISTORY_TABLE_H
+
+#include <array>
+#include <span>
+#include "chess_move.h"
+#include "chess_utils.h"
+
+/**
+ * Move ordering statistics collected from beta cutoffs:
+ * butterfly history of quiet moves [side][from][to], capture history [attacker][to][captured]
+ * and the quiet move that refuted the previous move [side][piece][to].
+ */
+class history_table {
+    static constexpr int32_t MaxHistory = 16384;
+    static constexpr int32_t MaxBonus = 2048;
+
+    std::array<std::array<std::array<int32_t, 64>, 64>, 2> butterfly;
+    std::array<std::array<std::array<int32_t, 6>, 64>, 6> capture_history;
+    std::array<std::array<std::array<chess_move, 64>, 6>, 2> countermoves;
+
+    static void update(int32_t& value, int32_t bonus);
+    static uint8_t captured_piece(const chess_move& move);
+    int32_t& get_capture_entry(const chess_move& move);
+public:
+    static constexpr size_t MaxSearchedMoves = 32; // searched moves that get a malus on a cutoff
+
+    history_table();
+    void clear();
+    void age();
+
+    /**
+     * Rewards the move that caused a beta cutoff and penalizes the moves of the same kind searched before it.
+     */
+    void add_cutoff(uint8_t side, const chess_move& move, const chess_move& previous_move, int depth,
+                    std::span<const chess_move> searched_quiets, std::span<const chess_move> searched_captures);
+    [[nodiscard]] int32_t get_quiet_score(uint8_t side, const chess_move& move) const;
+    [[nodiscard]] int32_t get_capture_score(const chess_move& move) const;
+    [[nodiscard]] chess_move get_countermove(uint8_t side, const chess_move& previous_move) const;
+};
+
+
+#endif //CHESSUCIENGINE_HISTORY_TABLE_H
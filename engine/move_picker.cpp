@@ -0,0 +1,129 @@
+#include "move_picker.h"
+#include "chess_move_generator.h"
+#include "static_evaluator.h"
+
+using namespace std;
+
+move_picker::move_picker(search_frame& frame, const game_state& state, const chess_move& hash_move,
+                         const history_table& history, const chess_move& countermove, bool only_captures) :
+        moves(frame.moves), scores(frame.scores), killers(frame.killers), state(state), history(history), 
+        hash_move(hash_move), countermove(countermove),
+        only_captures(only_captures), current_stage(stage::HashMove), current(0), losing_captures_begin(0), killers_begin(0), pawn_capture_mask(0) {
+    moves.clear();
+    // the hash move may come from another position after a key collision, so it has to be validated
+    if (!chess_move_generator::is_valid_move(hash_move, state) || (only_captures && !state.is_capture(hash_move))) {
+        this->hash_move = move::Invalid;
+    }
+}
+
+chess_move move_picker::next() {
+    switch (current_stage) {
+        case stage::HashMove:
+            current_stage = stage::GenerateCaptures;
+            if (move::is_valid(hash_move)) return hash_move;
+            [[fallthrough]];
+        case stage::GenerateCaptures:
+            chess_move_generator::generate_moves_of_type<chess_move_generator::move_type::Captures>(moves, state, state.side);
+            pawn_capture_mask =
+                    legal_move_mask::generate_left_pawn_capture_mask(state, chess::inverse_color(state.side), true) |
+                    legal_move_mask::generate_right_pawn_capture_mask(state, chess::inverse_color(state.side), true);
+            score_moves(0);
+            current_stage = stage::Captures;
+            [[fallthrough]];
+        case stage::Captures:
+            while (current < moves.size()) {
+                auto move = pick_best(moves.size());
+                if (scores[current - 1] < LosingCapture / 2) {
+                    // the rest of the captures lose material, they are left in place for the last stage
+                    current--;
+                    break;
+                }
+                if (move != hash_move) return move;
+            }
+            losing_captures_begin = current;
+            if (only_captures) {
+                current_stage = stage::Done;
+                return move::Invalid;
+            }
+            // killers are appended after the captures, quiet moves overwrite them later
+            killers_begin = moves.size();
+            for (const auto& killer : killers.moves) {
+                if (killer != hash_move && move::is_quiet(killer) && chess_move_generator::is_valid_move(killer, state)) {
+                    moves.push_back(killer);
+                }
+            }
+            // the losing captures are skipped until their own stage
+            current = killers_begin;
+            current_stage = stage::Killers;
+            [[fallthrough]];
+        case stage::Killers:
+            if (current < moves.size()) return moves[current++];
+            current_stage = stage::GenerateQuiets;
+            [[fallthrough]];
+        case stage::GenerateQuiets:
+            moves.resize(killers_begin);
+            current = killers_begin;
+            chess_move_generator::generate_moves_of_type<chess_move_generator::move_type::Quiets>(moves, state, state.side);
+            score_moves(killers_begin);
+            current_stage = stage::Quiets;
+            [[fallthrough]];
+        case stage::Quiets:
+            while (current < moves.size()) {
+                auto move = pick_best(moves.size());
+                if (move != hash_move && !killers.contains(move)) return move;
+            }
+            current = losing_captures_begin;
+            current_stage = stage::LosingCaptures;
+            [[fallthrough]];
+        case stage::LosingCaptures:
+            while (current < killers_begin) {
+                auto move = pick_best(killers_begin);
+                if (move != hash_move) return move;
+            }
+            current_stage = stage::Done;
+            [[fallthrough]];
+        case stage::Done:
+            return move::Invalid;
+    }
+    return move::Invalid;
+}
+
+void move_picker::score_moves(uint8_t begin) {
+    for (uint8_t i = begin; i < moves.size(); i++) {
+        scores[i] = eval_move(moves[i]);
+    }
+}
+
+chess_move move_picker::pick_best(uint8_t end) {
+    // selection step: only the moves that are actually searched get sorted
+    uint8_t best = current;
+    for (uint8_t i = current + 1; i < end; i++) {
+        if (scores[i] > scores[best]) best = i;
+    }
+    swap(moves[current], moves[best]);
+    swap(scores[current], scores[best]);
+    return moves[current++];
+}
+
+int32_t move_picker::eval_move(const chess_move& move) const {
+    int32_t result = 0;
+    if (move::is_quiet(move) && move::attacker(move) != chess::Pawn && get_bit(pawn_capture_mask, move::to(move))) {
+        result -= static_evaluator::material_cost[move::attacker(move)];
+    }
+    if (move::defender(move) != chess::EmptyPiece) {
+        result += 1000 * static_evaluator::material_cost[move::defender(move)];
+        result -= static_evaluator::material_cost[move::attacker(move)];
+    }
+    if (move::is_quiet(move)) {
+        result += history.get_quiet_score(state.side, move);
+        if (move == countermove) result += CountermoveBonus;
+    } else {
+        result += history.get_capture_score(move);
+        // a capture of a piece at least as valuable as the attacker can't lose material
+        auto defender = move::defender(move);
+        bool is_safe = defender != chess::EmptyPiece &&
+                static_evaluator::material_cost[defender] >= static_evaluator::material_cost[move::attacker(move)];
+        if (!is_safe && static_evaluator::static_exchange(state, move) < 0) result += LosingCapture;
+    }
+    return result;
+}
@@ -0,0 +1,51 @@
+#ifndef CHESSUCIENGINE_MOVE_PICKER_H
+#define CHESSUCIENGINE_MOVE_PICKER_H
+
+#include <array>
+#include "chess_move.h"
+#include "game_state.h"
+#include "move_list.h"
+#include "search_stack.h"
+#include "history_table.h"
+#include "chess_utils.h"
+
+/**
+ * Returns legal moves of a node one by one in stages: the hash move before any generation,
+ * then winning and equal captures picked by score, then killers, then quiet moves picked by score,
+ * then captures that lose material by static exchange evaluation.
+ * Later stages are generated only when the previous ones didn't cut the node.
+ * With only_captures losing captures are not returned at all.
+ */
+class move_picker {
+    enum class stage : uint8_t {
+        HashMove, GenerateCaptures, Captures, Killers, GenerateQuiets, Quiets, LosingCaptures, Done
+    };
+    static constexpr int32_t CountermoveBonus = 20000; // above any history score
+    static constexpr int32_t LosingCapture = -100000000; // below any other score
+
+    move_list& moves;
+    move_scores& scores;
+    const killer_moves& killers;
+    const game_state& state;
+    const history_table& history;
+    chess_move hash_move;
+    chess_move countermove;
+    bool only_captures;
+    stage current_stage;
+    uint8_t current; // index of the next move to return from the list
+    uint8_t losing_captures_begin;
+    uint8_t killers_begin; // also the end of losing captures
+    bitboard pawn_capture_mask;
+
+    void score_moves(uint8_t begin);
+    chess_move pick_best(uint8_t end);
+    [[nodiscard]] int32_t eval_move(const chess_move& move) const;
+public:
+    // the moves are generated into the frame and the killers are taken from it
+    move_picker(search_frame& frame, const game_state& state, const chess_move& hash_move,
+                const history_table& history, const chess_move& countermove, bool only_captures = false);
+    chess_move next(); // move::Invalid when there are no moves left
+};
+
+
+#endif //CHESSUCIENGINE_MOVE_PICKER_H
@@ -0,0 +1,54 @@
+#ifndef CHESSUCIENGINE_SEARCH_FEATURES_H
+#define CHESSUCIENGINE_SEARCH_FEATURES_H
+
+// Every heuristic is on by default, a benchmark build turns one off with e.g. -DSEARCH_NULL_MOVE=false
+#ifndef SEARCH_NULL_MOVE
+#define SEARCH_NULL_MOVE true
+#endif
+#ifndef SEARCH_LATE_MOVE_REDUCTIONS
+#define SEARCH_LATE_MOVE_REDUCTIONS true
+#endif
+#ifndef SEARCH_FUTILITY_PRUNING
+#define SEARCH_FUTILITY_PRUNING true
+#endif
+#ifndef SEARCH_REVERSE_FUTILITY_PRUNING
+#define SEARCH_REVERSE_FUTILITY_PRUNING true
+#endif
+#ifndef SEARCH_RAZORING
+#define SEARCH_RAZORING true
+#endif
+#ifndef SEARCH_PROBCUT
+#define SEARCH_PROBCUT true
+#endif
+#ifndef SEARCH_INTERNAL_DEEPENING
+#define SEARCH_INTERNAL_DEEPENING true
+#endif
+#ifndef SEARCH_SINGULAR_EXTENSIONS
+#define SEARCH_SINGULAR_EXTENSIONS true
+#endif
+#ifndef SEARCH_CHECK_EXTENSIONS
+#define SEARCH_CHECK_EXTENSIONS true
+#endif
+#ifndef SEARCH_DELTA_PRUNING
+#define SEARCH_DELTA_PRUNING true
+#endif
+
+/**
+ * Heuristics compiled into the search. A disabled one is removed from the search at compile time,
+ * so comparing two builds measures the heuristic alone.
+ */
+struct search_features {
+    static constexpr bool NullMove = SEARCH_NULL_MOVE;
+    static constexpr bool LateMoveReductions = SEARCH_LATE_MOVE_REDUCTIONS;
+    static constexpr bool FutilityPruning = SEARCH_FUTILITY_PRUNING;
+    static constexpr bool ReverseFutilityPruning = SEARCH_REVERSE_FUTILITY_PRUNING;
+    static constexpr bool Razoring = SEARCH_RAZORING;
+    static constexpr bool ProbCut = SEARCH_PROBCUT;
+    static constexpr bool InternalDeepening = SEARCH_INTERNAL_DEEPENING;
+    static constexpr bool SingularExtensions = SEARCH_SINGULAR_EXTENSIONS; // the runtime option can turn them off too
+    static constexpr bool CheckExtensions = SEARCH_CHECK_EXTENSIONS;
+    static constexpr bool DeltaPruning = SEARCH_DELTA_PRUNING;
+};
+
+
+#endif //CHESSUCIENGINE_SEARCH_FEATURES_H
@@ -0,0 +1,24 @@
+#ifndef CHESSUCIENGINE_SEARCH_LIMITS_H
+#define CHESSUCIENGINE_SEARCH_LIMITS_H
+
+#include "chess_move.h"
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Limits of a single search as given by the UCI "go" command, zero means "not set"
+struct search_limits {
+    std::chrono::milliseconds wtime{0};
+    std::chrono::milliseconds btime{0};
+    std::chrono::milliseconds winc{0};
+    std::chrono::milliseconds binc{0};
+    std::chrono::milliseconds movetime{0};
+    int movestogo = 0;
+    uint64_t nodes = 0;
+    int depth = 0;
+    bool infinite = false;
+    bool ponder = false; // no time limits until ponderhit, then the clock limits apply
+    std::vector<chess_move> searchmoves; // the only root moves to search, all of them when empty
+};
+
+#endif //CHESSUCIENGINE_SEARCH_LIMITS_H
@@ -0,0 +1,37 @@
+#include "search_stack.h"
+#include <algorithm>
+
+using namespace std;
+
+void killer_moves::add(const chess_move& move) {
+    if (moves[0] == move) return;
+    // the oldest killer is dropped, a move already in the list moves to the front
+    auto last = find(moves.begin(), moves.end() - 1, move);
+    move_backward(moves.begin(), last, last + 1);
+    moves[0] = move;
+}
+
+void killer_moves::clear() {
+    moves.fill(move::Invalid);
+}
+
+bool killer_moves::contains(const chess_move& move) const {
+    return find(moves.begin(), moves.end(), move) != moves.end();
+}
+
+search_stack::search_stack() : frames(make_unique<search_frame[]>(MaxPly)) {
+    for (size_t ply = 0; ply < MaxPly; ply++) {
+        auto& frame = frames[ply];
+        frame.killers.clear();
+        frame.current_move = move::Invalid;
+        frame.excluded_move = move::Invalid;
+        frame.static_eval = 0;
+        frame.extension = 0;
+    }
+}
+
+void search_stack::clear() {
+    for (size_t ply = 0; ply < MaxPly; ply++) {
+        frames[ply].killers.clear();
+    }
+}
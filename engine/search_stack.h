@@ -0,0 +1,60 @@
+#ifndef CHESSUCIENGINE_SEARCH_STACK_H
+#define CHESSUCIENGINE_SEARCH_STACK_H
+
+#include <array>
+#include <memory>
+#include "chess_move.h"
+#include "move_list.h"
+
+/**
+ * Quiet moves that recently caused a beta cutoff at one ply, the newest first.
+ */
+struct killer_moves {
+    static constexpr size_t SlotsCount = 2;
+    std::array<chess_move, SlotsCount> moves;
+
+    void add(const chess_move& move);
+    void clear();
+    [[nodiscard]] bool contains(const chess_move& move) const;
+};
+
+using move_scores = std::array<int32_t, std::tuple_size_v<array_type>>;
+
+/**
+ * Everything the search keeps for one ply of the current line. The fields used by every node come first
+ * and share a cache line, the move list and the scores of the move picker follow.
+ */
+struct alignas(64) search_frame {
+    killer_moves killers;
+    chess_move current_move; // made at this ply, move::Invalid for a null move
+    chess_move excluded_move; // skipped by the singular search of the hash move at this ply
+    int32_t static_eval; // of the side to move, not defined in check
+    int extension; // of the line up to this ply, in fractions of a ply
+    move_list moves;
+    move_scores scores;
+};
+
+/**
+ * Frames of all plies a search thread can reach, allocated once as a single block.
+ * Frame 0 stands before the root, so the root sees no previous move.
+ */
+class search_stack {
+public:
+    // extensions are bounded by the root depth, so a line of the main search is at most twice as long as
+    // the root depth (which helpers exceed by one), and quiescence search adds at most one capture per piece;
+    // the search still cuts every line a few plies before the end, so a wrong bound can't run past the frames
+    static constexpr size_t MaxPly = 256;
+private:
+    std::unique_ptr<search_frame[]> frames;
+public:
+    search_stack();
+    void clear(); // forgets the killers
+
+    search_frame& operator[](size_t ply) {
+        Assert(ply < MaxPly)
+        return frames[ply];
+    }
+};
+
+
+#endif //CHESSUCIENGINE_SEARCH_STACK_H
@@ -0,0 +1,60 @@
+#include "search_statistics.h"
+#include <algorithm>
+#include <sstream>
+
+using namespace std;
+
+const array<const char*, search_statistics::CountersCount> search_statistics::names = {
+    "main_search_nodes", "zero_window_nodes", "capture_search_nodes",
+    "transposition_found", "transposition_best_hit", "transposition_cutoffs",
+    "pvs_research_count", "late_move_research_count", "aspiration_fail_low", "aspiration_fail_high",
+    "null_move_cutoffs", "reverse_futility_cutoffs", "futility_pruned_moves", "razoring_cutoffs", "delta_pruned_moves",
+    "beta_cutoffs", "first_move_cutoffs", "singular_extended_moves", "internal_deepenings", "probcut_cutoffs"
+};
+
+search_statistics& search_statistics::operator+=(const search_statistics& other) {
+    for (size_t i = 0; i < CountersCount; i++) {
+        values[i] += other.values[i];
+    }
+    max_depth = max(max_depth, other.max_depth);
+    return *this;
+}
+
+string search_statistics::to_string() const {
+    stringstream ss;
+    ss << "max_depth " << max_depth;
+    for (size_t i = 0; i < CountersCount; i++) {
+        ss << " " << names[i] << " " << values[i];
+    }
+    return ss.str();
+}
+
+string search_statistics::to_json() const {
+    stringstream ss;
+    ss << "{\"max_depth\":" << max_depth;
+    for (size_t i = 0; i < CountersCount; i++) {
+        ss << ",\"" << names[i] << "\":" << values[i];
+    }
+    ss << "}";
+    return ss.str();
+}
+
+search_counters::search_counters() : values(), max_depth(0) {
+    clear();
+}
+
+void search_counters::clear() {
+    for (auto& value : values) {
+        value.store(0, memory_order_relaxed);
+    }
+    max_depth.store(0, memory_order_relaxed);
+}
+
+search_statistics search_counters::snapshot() const {
+    search_statistics result;
+    for (size_t i = 0; i < search_statistics::CountersCount; i++) {
+        result.values[i] = values[i].load(memory_order_relaxed);
+    }
+    result.max_depth = max_depth.load(memory_order_relaxed);
+    return result;
+}
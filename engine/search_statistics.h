@@ -0,0 +1,54 @@
+#ifndef CHESSUCIENGINE_SEARCH_STATISTICS_H
+#define CHESSUCIENGINE_SEARCH_STATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * Snapshot of the search counters, summed over the search threads.
+ */
+struct search_statistics {
+    enum counter : size_t {
+        MainSearchNodes, ZeroWindowNodes, CaptureSearchNodes,
+        TranspositionFound, TranspositionBestHit, TranspositionCutoffs,
+        PvsResearches, LateMoveResearches, AspirationFailLow, AspirationFailHigh,
+        NullMoveCutoffs, ReverseFutilityCutoffs, FutilityPrunedMoves, RazoringCutoffs, DeltaPrunedMoves,
+        BetaCutoffs, FirstMoveCutoffs, SingularExtendedMoves, InternalDeepenings, ProbCutCutoffs,
+        CountersCount
+    };
+    static const std::array<const char*, CountersCount> names;
+
+    std::array<uint64_t, CountersCount> values{};
+    uint64_t max_depth = 0; // the deepest ply reached by any thread
+
+    search_statistics& operator+=(const search_statistics& other);
+    [[nodiscard]] uint64_t operator[](counter c) const { return values[c]; }
+    [[nodiscard]] std::string to_string() const; // "name value" pairs for an "info string" line
+    [[nodiscard]] std::string to_json() const;
+};
+
+/**
+ * Counters of one search thread. They are written by the owning thread only, so an increment is
+ * a relaxed load and store without a locked instruction, while other threads may read them at any time.
+ */
+class search_counters {
+    std::array<std::atomic<uint64_t>, search_statistics::CountersCount> values;
+    std::atomic<uint64_t> max_depth;
+public:
+    search_counters();
+    void clear();
+    [[nodiscard]] search_statistics snapshot() const;
+
+    void increment(search_statistics::counter c) {
+        values[c].store(values[c].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void update_max_depth(uint64_t depth) {
+        if (depth > max_depth.load(std::memory_order_relaxed)) max_depth.store(depth, std::memory_order_relaxed);
+    }
+};
+
+
+#endif //CHESSUCIENGINE_SEARCH_STATISTICS_H
@@ -1,6 +1,7 @@
 #include "static_evaluator.h"
 #include "chess_utils.h"
 #include "legal_move_mask.h"
+#include "chess_move_generator.h"
 
 using namespace std;
 
@@ -25,6 +26,79 @@ int32_t static_evaluator::evaluate(const game_state& state) {
     return value;
 }
 
+int32_t static_evaluator::static_exchange(const game_state& state, const chess_move& move) {
+    auto from = move::from(move);
+    auto to = move::to(move);
+    auto flag = move::flag(move);
+    uint8_t piece = move::attacker(move);
+    array<int32_t, 32> gain{};
+    bitboard occupied = state.all;
+    set_0(occupied, from);
+    if (flag == move::move_flag::EnPassantCapture) {
+        gain[0] = material_cost[chess::Pawn];
+        set_0(occupied, state.side == chess::White ? to - 8 : to + 8);
+    } else if (move::defender(move) != chess::EmptyPiece) {
+        gain[0] = material_cost[move::defender(move)];
+    }
+    if (flag >= move::move_flag::PromoteToKnight) {
+        constexpr array<uint8_t, 4> promotions = {chess::Knight, chess::Bishop, chess::Rook, chess::Queen};
+        piece = promotions[static_cast<uint8_t>(flag) - static_cast<uint8_t>(move::move_flag::PromoteToKnight)];
+        gain[0] += material_cost[piece] - material_cost[chess::Pawn];
+    }
+
+    bitboard diagonal = state.board[chess::White][chess::Bishop] | state.board[chess::Black][chess::Bishop] |
+                        state.board[chess::White][chess::Queen] | state.board[chess::Black][chess::Queen];
+    bitboard straight = state.board[chess::White][chess::Rook] | state.board[chess::Black][chess::Rook] |
+                        state.board[chess::White][chess::Queen] | state.board[chess::Black][chess::Queen];
+    // attackers_to returns attackers of the opposite side, so both calls are needed for all attackers
+    bitboard attackers = (chess_move_generator::attackers_to(state, occupied, to, chess::White) |
+                          chess_move_generator::attackers_to(state, occupied, to, chess::Black)) & occupied;
+    uint8_t side = chess::inverse_color(state.side);
+    int depth = 0;
+    while (depth + 1 < static_cast<int>(gain.size())) {
+        uint8_t next_piece;
+        auto square = least_valuable_piece(state, attackers, side, next_piece);
+        if (!square) break;
+        // the king can only recapture when the square is not defended anymore
+        if (next_piece == chess::King && (attackers & state.side_board[chess::inverse_color(side)] & ~square)) break;
+        depth++;
+        gain[depth] = material_cost[piece] - gain[depth - 1];
+        if (max(-gain[depth - 1], gain[depth]) < 0) {
+            // the capture can't change the result, the side to move stops before it
+            depth--;
+            break;
+        }
+        piece = next_piece;
+        occupied ^= square;
+        // the piece has left the square, sliders behind it now attack the target
+        if (next_piece == chess::Pawn || next_piece == chess::Bishop || next_piece == chess::Queen) {
+            attackers |= legal_move_mask::generate_figure_mask<chess::Bishop>(to, occupied) & diagonal;
+        }
+        if (next_piece == chess::Rook || next_piece == chess::Queen) {
+            attackers |= legal_move_mask::generate_figure_mask<chess::Rook>(to, occupied) & straight;
+        }
+        attackers &= occupied;
+        side = chess::inverse_color(side);
+    }
+    while (depth > 0) {
+        gain[depth - 1] = -max(-gain[depth - 1], gain[depth]);
+        depth--;
+    }
+    return gain[0];
+}
+
+bitboard static_evaluator::least_valuable_piece(const game_state& state, bitboard attackers, uint8_t side, uint8_t& piece) {
+    constexpr array<uint8_t, 6> order = {chess::Pawn, chess::Knight, chess::Bishop, chess::Rook, chess::Queen, chess::King};
+    for (auto type : order) {
+        auto subset = attackers & state.board[side][type];
+        if (subset) {
+            piece = type;
+            return 1ULL << lsb(subset);
+        }
+    }
+    return 0;
+}
+
 int32_t static_evaluator::material(const game_state& state) {
     int32_t result = 0;
     for (int type = chess::Queen; type <= chess::Pawn; type++) {
@@ -4,9 +4,11 @@
 #include <cstdint>
 #include <array>
 #include "game_state.h"
+#include "chess_move.h"
 
 class static_evaluator {
     friend class dynamic_evaluator;
+    friend class move_picker;
     static constexpr std::array<int32_t, 6> material_cost {
         950, // queen 
         0,   // king is unused
@@ -44,8 +46,16 @@ class static_evaluator {
     static bool is_endgame(const game_state& state);
     static int32_t endgame_evaluation(const game_state& state, bool white_leading);
     static bool is_obvious_draw(const game_state& state);
+    static bitboard least_valuable_piece(const game_state& state, bitboard attackers, uint8_t side, uint8_t& piece);
 public:
     static int32_t evaluate(const game_state& state);
+
+    /**
+     * Static exchange evaluation: material balance of the sequence of captures on the target square of the move,
+     * where both sides recapture with the least valuable piece and may stop when it's not profitable.
+     * Pieces behind the capturing ones are discovered as x-ray attackers, pins are ignored.
+     */
+    static int32_t static_exchange(const game_state& state, const chess_move& move);
 };
 
 
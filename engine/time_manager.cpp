@@ -0,0 +1,43 @@
+#include "time_manager.h"
+#include "chess_utils.h"
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+time_manager::time_manager() : start(clock::now()), soft_limit(0), hard_limit(0), limited(false) {}
+
+void time_manager::init(const search_limits& limits, uint8_t side) {
+    start = clock::now();
+    limited = false;
+    if (limits.infinite || limits.ponder) return;
+    
+    if (limits.movetime > 0ms) {
+        limited = true;
+        hard_limit = max(1ms, limits.movetime - MoveOverhead);
+        soft_limit = hard_limit;
+        return;
+    }
+    
+    auto time = side == chess::White ? limits.wtime : limits.btime;
+    auto increment = side == chess::White ? limits.winc : limits.binc;
+    if (time <= 0ms) return;
+    
+    limited = true;
+    int moves_to_go = limits.movestogo > 0 ? limits.movestogo : DefaultMovesToGo;
+    auto available = max(1ms, time - MoveOverhead);
+    hard_limit = min(available, (available / moves_to_go + increment) * HardLimitFactor);
+    soft_limit = min(hard_limit, available / moves_to_go + increment * 3 / 4);
+}
+
+milliseconds time_manager::elapsed() const {
+    return duration_cast<milliseconds>(clock::now() - start);
+}
+
+bool time_manager::soft_limit_reached() const {
+    return limited && elapsed() >= soft_limit;
+}
+
+bool time_manager::hard_limit_reached() const {
+    return limited && elapsed() >= hard_limit;
+}
@@ -0,0 +1,30 @@
+#ifndef CHESSUCIENGINE_TIME_MANAGER_H
+#define CHESSUCIENGINE_TIME_MANAGER_H
+
+#include "search_limits.h"
+#include <chrono>
+
+/**
+ * Splits the remaining clock into a soft limit, after which no new iteration is started,
+ * and a hard limit, after which the running iteration is aborted.
+ */
+class time_manager {
+    using clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds MoveOverhead{20};
+    static constexpr int DefaultMovesToGo = 30;
+    static constexpr int HardLimitFactor = 4;
+
+    clock::time_point start;
+    std::chrono::milliseconds soft_limit;
+    std::chrono::milliseconds hard_limit;
+    bool limited;
+public:
+    time_manager();
+    void init(const search_limits& limits, uint8_t side);
+    [[nodiscard]] std::chrono::milliseconds elapsed() const;
+    [[nodiscard]] bool soft_limit_reached() const;
+    [[nodiscard]] bool hard_limit_reached() const;
+};
+
+
+#endif //CHESSUCIENGINE_TIME_MANAGER_H
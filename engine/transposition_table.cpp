@@ -1,16 +1,130 @@
 #include "transposition_table.h"
+#include "chess_utils.h"
+#include <bit>
+#include <limits>
+#include <algorithm>
 
-void transposition_table::add(const game_state& state, int depth, chess_move best_move, bool is_pv) {
+using namespace std;
+
+static uint16_t fold_payload(uint64_t data) {
+    return (data >> 16) ^ (data >> 32) ^ (data >> 48);
+}
+
+uint64_t transposition_table::entry::pack() const {
+    uint64_t data = static_cast<uint64_t>(move) << 16 |
+                    static_cast<uint64_t>(static_cast<uint16_t>(score)) << 32 |
+                    static_cast<uint64_t>(depth) << 48 |
+                    static_cast<uint64_t>(static_cast<uint8_t>(bound_type) | is_pv << 2 | age << 3) << 56;
+    return data | static_cast<uint16_t>(key ^ fold_payload(data));
+}
+
+transposition_table::entry transposition_table::entry::unpack(uint64_t data) {
+    uint8_t flags = data >> 56;
+    return entry {
+        static_cast<uint16_t>(data ^ fold_payload(data)),
+        static_cast<uint16_t>(data >> 16),
+        static_cast<int16_t>(data >> 32),
+        static_cast<uint8_t>(data >> 48),
+        static_cast<bound>(flags & 0x3),
+        static_cast<bool>(flags >> 2 & 1),
+        static_cast<uint8_t>(flags >> 3)
+    };
+}
+
+transposition_table::transposition_table(size_t size_mb) : bucket_mask(0), age(0) {
+    resize(size_mb);
+}
+
+void transposition_table::resize(size_t size_mb) {
+    size_t bucket_count = bit_floor(max<size_t>(1, size_mb * 1024 * 1024 / sizeof(bucket)));
+    buckets = make_unique<bucket[]>(bucket_count);
+    bucket_mask = bucket_count - 1;
+}
+
+void transposition_table::clear() {
+    for (size_t i = 0; i <= bucket_mask; i++) {
+        for (auto& data : buckets[i].entries) {
+            data.store(0, memory_order_relaxed);
+        }
+    }
+    age = 0;
+}
+
+void transposition_table::new_search() {
+    age = (age + 1) & AgeMask;
+}
+
+transposition_table::bucket& transposition_table::get_bucket(uint64_t hash) {
+    // low bits of the hash select the bucket, high bits are used for the key check 
+    return buckets[hash & bucket_mask];
+}
+
+int32_t transposition_table::score_to_table(int32_t score, int real_depth) {
+    // mate scores are stored relative to the current node, not to the root
+    if (score >= chess::MateThreshold) return score + real_depth;
+    if (score <= -chess::MateThreshold) return score - real_depth;
+    return score;
+}
+
+int32_t transposition_table::score_from_table(int32_t score, int real_depth) {
+    if (score >= chess::MateThreshold) return score - real_depth;
+    if (score <= -chess::MateThreshold) return score + real_depth;
+    return score;
+}
+
+void transposition_table::add(const game_state& state, int depth, int real_depth, int32_t score, bound bound_type,
+                              chess_move best_move, bool is_pv) {
     auto hash = state.hash.value;
-    auto iter = map.find(hash);
-    if (iter == map.end() || iter->second.depth < depth || (!iter->second.is_pv && is_pv)) {
-        map[hash] = entry {depth, best_move, is_pv};
+    auto key = static_cast<uint16_t>(hash >> 48);
+    auto& bucket = get_bucket(hash);
+    auto packed_move = move::pack(best_move);
+    size_t replace_index = 0;
+    int replace_value = numeric_limits<int>::max();
+    for (size_t i = 0; i < BucketSize; i++) {
+        auto data = bucket.entries[i].load(memory_order_relaxed);
+        if (data == 0) {
+            replace_index = i;
+            break;
+        }
+        auto old = entry::unpack(data);
+        if (old.key == key) {
+            bool keep_exact = old.depth == depth && old.bound_type == bound::Exact && bound_type != bound::Exact;
+            if (old.age == age && (old.depth > depth || keep_exact)) return;
+            if (packed_move == 0) packed_move = old.move; // keep the move of a fail-low re-search
+            replace_index = i;
+            break;
+        }
+        // prefer to replace shallow entries from previous searches
+        int value = old.depth + (old.is_pv ? 1 : 0) - 8 * ((age - old.age) & AgeMask);
+        if (value < replace_value) {
+            replace_value = value;
+            replace_index = i;
+        }
     }
+    auto table_score = clamp<int32_t>(score_to_table(score, real_depth), numeric_limits<int16_t>::min(), numeric_limits<int16_t>::max());
+    entry new_entry {key, packed_move, static_cast<int16_t>(table_score), 
+                     static_cast<uint8_t>(clamp(depth, 0, 255)), bound_type, is_pv, age};
+    bucket.entries[replace_index].store(new_entry.pack(), memory_order_relaxed);
 }
 
-chess_move transposition_table::try_get_best_move(const game_state& state) {
+transposition_table::probe_result transposition_table::probe(const game_state& state, int real_depth) {
     auto hash = state.hash.value;
-    auto iter = map.find(hash);
-    if (iter == map.end()) return move::Invalid;
-    return iter->second.best_move;
-}
\ No newline at end of file
+    auto key = static_cast<uint16_t>(hash >> 48);
+    auto& bucket = get_bucket(hash);
+    for (const auto& slot : bucket.entries) {
+        auto data = slot.load(memory_order_relaxed);
+        if (data == 0) continue;
+        auto found = entry::unpack(data);
+        if (found.key != key) continue;
+        probe_result result {true, move::Invalid, score_from_table(found.score, real_depth), found.depth, found.bound_type};
+        auto move = move::unpack(found.move, chess::EmptyPiece, chess::EmptyPiece);
+        if (move::is_valid(move)) {
+            auto attacker = state.get_piece(state.side, move::from(move));
+            if (attacker != chess::EmptyPiece) {
+                result.best_move = move::unpack(found.move, attacker, state.get_piece(chess::inverse_color(state.side), move::to(move)));
+            }
+        }
+        return result;
+    }
+    return probe_result {false, move::Invalid, 0, 0, bound::None};
+}
@@ -2,19 +2,73 @@
 #define CHESSUCIENGINE_TRANSPOSITION_TABLE_H
 
 #include "game_state.h"
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <memory>
 
 class transposition_table {
-    struct entry {
-        int depth;
+public:
+    enum class bound : uint8_t { None, Upper, Lower, Exact };
+    
+    struct probe_result {
+        bool found;
         chess_move best_move;
+        int32_t score;
+        int depth;
+        bound bound_type;
+    };
+
+private:
+    /**
+     * Every entry is packed into a single 64-bit word:
+     * [0-15 bits] key check: high 16 bits of the hash xor'ed with the rest of the entry
+     * [16-31 bits] packed best move
+     * [32-47 bits] score
+     * [48-55 bits] depth
+     * [56-57 bits] bound
+     * [58 bit] is pv
+     * [59-63 bits] age
+     */
+    struct entry {
+        uint16_t key;
+        uint16_t move;
+        int16_t score;
+        uint8_t depth;
+        bound bound_type;
         bool is_pv;
+        uint8_t age;
+
+        [[nodiscard]] uint64_t pack() const;
+        static entry unpack(uint64_t data);
     };
-    
-    std::unordered_map<uint64_t, entry> map;
+
+    static constexpr size_t BucketSize = 8;
+    static constexpr uint8_t AgeMask = 0x1F;
+
+    // Entries of one bucket share a cache line, so a probe touches a single line.
+    // The key check is xor'ed with the payload, so entries are written without locks:
+    // a payload written by another thread for a different position fails the check.
+    struct alignas(64) bucket {
+        std::array<std::atomic<uint64_t>, BucketSize> entries;
+    };
+
+    std::unique_ptr<bucket[]> buckets;
+    size_t bucket_mask;
+    uint8_t age;
+
+    bucket& get_bucket(uint64_t hash);
+    static int32_t score_to_table(int32_t score, int real_depth);
+    static int32_t score_from_table(int32_t score, int real_depth);
 public:
-    void add(const game_state& state, int depth, chess_move best_move, bool is_pv);
-    chess_move try_get_best_move(const game_state& state);
+    static constexpr size_t DefaultSizeMb = 64;
+
+    explicit transposition_table(size_t size_mb = DefaultSizeMb);
+    void resize(size_t size_mb);
+    void clear();
+    void new_search();
+    void add(const game_state& state, int depth, int real_depth, int32_t score, bound bound_type,
+             chess_move best_move, bool is_pv);
+    probe_result probe(const game_state& state, int real_depth);
 };
 
 
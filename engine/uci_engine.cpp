@@ -0,0 +1,218 @@
+#include "uci_engine.h"
+#include "chess_move_generator.h"
+#include <iostream>
+#include <algorithm>
+
+using namespace std;
+
+uci_engine::uci_engine() : state(StartPosition), evaluator(make_unique<dynamic_evaluator>()), 
+        report_statistics(false), out(&cout) {
+    evaluator->info_callback = [this](const search_info& info) { send_info(info); };
+}
+
+uci_engine::~uci_engine() {
+    stop_search();
+}
+
+void uci_engine::run(istream& in, ostream& output) {
+    out = &output;
+    string line;
+    while (getline(in, line)) {
+        istringstream command(line);
+        string token;
+        command >> token;
+        if (token == "uci") {
+            handle_uci();
+        } else if (token == "isready") {
+            send("readyok");
+        } else if (token == "setoption") {
+            handle_setoption(command);
+        } else if (token == "ucinewgame") {
+            stop_search();
+            state = game_state(StartPosition);
+            game_history.clear();
+            evaluator->new_game();
+        } else if (token == "position") {
+            handle_position(command);
+        } else if (token == "go") {
+            handle_go(command);
+        } else if (token == "ponderhit") {
+            evaluator->ponderhit();
+        } else if (token == "stop") {
+            stop_search();
+        } else if (token == "stats") {
+            handle_stats(command);
+        } else if (token == "quit") {
+            break;
+        }
+    }
+    stop_search();
+}
+
+void uci_engine::send(const string& message) {
+    lock_guard<mutex> lock(output_mutex);
+    *out << message << endl;
+}
+
+void uci_engine::handle_uci() {
+    send("id name ChessUCIEngine");
+    send("id author Vyacheslav Moklev");
+    send("option name Threads type spin default 1 min 1 max " + to_string(MaxThreads));
+    send("option name Hash type spin default " + to_string(transposition_table::DefaultSizeMb) + 
+         " min 1 max " + to_string(MaxHashSizeMb));
+    send("option name SingularExtensions type check default true");
+    send("option name Ponder type check default false");
+    send("option name MultiPV type spin default 1 min 1 max " + to_string(MaxMultiPv));
+    send("option name Statistics type check default false");
+    send("option name ProbCutMargin type spin default " + to_string(dynamic_evaluator::DefaultProbCutMargin) + 
+         " min 0 max 1000");
+    send("option name ProbCutReduction type spin default " + to_string(dynamic_evaluator::DefaultProbCutReduction) + 
+         " min 1 max 8");
+    send("uciok");
+}
+
+void uci_engine::handle_setoption(istringstream& command) {
+    string token, name, value;
+    command >> token; // "name"
+    while (command >> token && token != "value") {
+        name += (name.empty() ? "" : " ") + token;
+    }
+    command >> value;
+    if (value.empty()) return;
+    stop_search();
+    if (name == "Threads") {
+        evaluator->set_threads(clamp(stoi(value), 1, MaxThreads));
+    } else if (name == "Hash") {
+        evaluator->set_hash_size(clamp<size_t>(stoull(value), 1, MaxHashSizeMb));
+    } else if (name == "SingularExtensions") {
+        evaluator->singular_extensions = value == "true";
+    } else if (name == "MultiPV") {
+        evaluator->multi_pv = clamp(stoi(value), 1, MaxMultiPv);
+    } else if (name == "ProbCutMargin") {
+        evaluator->probcut_margin = clamp(stoi(value), 0, 1000);
+    } else if (name == "ProbCutReduction") {
+        evaluator->probcut_reduction = clamp(stoi(value), 1, 8);
+    } else if (name == "Statistics") {
+        report_statistics = value == "true";
+    }
+}
+
+void uci_engine::handle_position(istringstream& command) {
+    stop_search();
+    string token;
+    command >> token;
+    game_history.clear();
+    if (token == "startpos") {
+        state = game_state(StartPosition);
+        command >> token; // "moves"
+    } else if (token == "fen") {
+        string fen;
+        while (command >> token && token != "moves") {
+            fen += (fen.empty() ? "" : " ") + token;
+        }
+        state = game_state(fen);
+    }
+    while (command >> token) {
+        auto move = parse_move(state, token);
+        if (!move::is_valid(move)) break;
+        game_history.push_back(state.hash.value);
+        state.apply_move(move);
+    }
+}
+
+void uci_engine::handle_go(istringstream& command) {
+    stop_search();
+    search_limits limits;
+    string token;
+    while (command >> token) {
+        if (token == "searchmoves") {
+            // the moves run until the next keyword
+            while (command >> token) {
+                auto move = parse_move(state, token);
+                if (!move::is_valid(move)) break;
+                limits.searchmoves.push_back(move);
+            }
+            if (!command) break;
+        }
+        if (token == "infinite") {
+            limits.infinite = true;
+            continue;
+        }
+        if (token == "ponder") {
+            limits.ponder = true;
+            continue;
+        }
+        int64_t value;
+        if (!(command >> value)) break;
+        if (token == "wtime") limits.wtime = chrono::milliseconds(value);
+        else if (token == "btime") limits.btime = chrono::milliseconds(value);
+        else if (token == "winc") limits.winc = chrono::milliseconds(value);
+        else if (token == "binc") limits.binc = chrono::milliseconds(value);
+        else if (token == "movetime") limits.movetime = chrono::milliseconds(value);
+        else if (token == "movestogo") limits.movestogo = static_cast<int>(value);
+        else if (token == "nodes") limits.nodes = value;
+        else if (token == "depth") limits.depth = static_cast<int>(value);
+    }
+
+    evaluator->clear_stop();
+    evaluator->game_history = game_history;
+    search_thread = thread([this, limits, root = state]() {
+        auto best_move = evaluator->find_best_move(root, limits);
+        // in infinite mode "bestmove" must not be sent before "stop", while pondering before "ponderhit" either
+        while ((limits.infinite || (limits.ponder && !evaluator->is_ponderhit_requested())) && 
+               !evaluator->is_stop_requested()) {
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+        if (report_statistics) send("info string " + evaluator->statistics().to_string());
+        if (!move::is_valid(best_move)) {
+            // mate or stalemate at the root, the null move is sent
+            send("bestmove 0000");
+            return;
+        }
+        auto ponder_move = evaluator->ponder_move;
+        send("bestmove " + move::to_string(best_move) + 
+             (move::is_valid(ponder_move) ? " ponder " + move::to_string(ponder_move) : ""));
+    });
+}
+
+/**
+ * Non-standard "stats [json]" command: counters of the last or running search, as "info string" or as a JSON line.
+ */
+void uci_engine::handle_stats(istringstream& command) {
+    string format;
+    command >> format;
+    auto statistics = evaluator->statistics();
+    send(format == "json" ? statistics.to_json() : "info string " + statistics.to_string());
+}
+
+void uci_engine::stop_search() {
+    if (!search_thread.joinable()) return;
+    evaluator->stop();
+    search_thread.join();
+}
+
+void uci_engine::send_info(const search_info& info) {
+    stringstream ss;
+    auto time = info.time.count();
+    ss << "info depth " << info.depth << " seldepth " << info.seldepth << " multipv " << info.multi_pv << " score " << format_score(info.score) 
+       << " nodes " << info.nodes << " nps " << info.nodes * 1000 / max<int64_t>(time, 1) << " time " << time 
+       << " pv " << move::to_string(info.best_move);
+    send(ss.str());
+}
+
+chess_move uci_engine::parse_move(const game_state& state, const string& move) {
+    move_list moves;
+    chess_move_generator::generate_all_moves(moves, state, state.side);
+    for (const auto& candidate : moves) {
+        if (move::to_string(candidate) == move) return candidate;
+    }
+    return move::Invalid;
+}
+
+string uci_engine::format_score(int32_t score) {
+    if (abs(score) < chess::MateThreshold) {
+        return "cp " + to_string(score);
+    }
+    int plies = chess::MateScore - abs(score) - 1; // root is searched with real_depth 1
+    return "mate " + to_string(score > 0 ? (plies + 1) / 2 : -plies / 2);
+}
@@ -0,0 +1,49 @@
+#ifndef CHESSUCIENGINE_UCI_ENGINE_H
+#define CHESSUCIENGINE_UCI_ENGINE_H
+
+#include "game_state.h"
+#include "dynamic_evaluator.h"
+#include "search_limits.h"
+#include <string>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <memory>
+#include <vector>
+
+/**
+ * UCI protocol loop. The search runs on its own thread, so "stop" and "isready"
+ * are handled while the engine is thinking.
+ */
+class uci_engine {
+    static constexpr const char* StartPosition = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+    static constexpr int MaxThreads = 256;
+    static constexpr size_t MaxHashSizeMb = 65536;
+    static constexpr int MaxMultiPv = 256;
+
+    game_state state;
+    std::vector<uint64_t> game_history; // keys of the positions before the current one
+    std::unique_ptr<dynamic_evaluator> evaluator; // lives as long as the engine, so the table survives between moves
+    bool report_statistics; // send the search counters as "info string" before every "bestmove"
+    std::thread search_thread;
+    std::mutex output_mutex;
+    std::ostream* out;
+
+    void send(const std::string& message);
+    void handle_uci();
+    void handle_setoption(std::istringstream& command);
+    void handle_position(std::istringstream& command);
+    void handle_go(std::istringstream& command);
+    void handle_stats(std::istringstream& command);
+    void stop_search();
+    void send_info(const search_info& info);
+    static chess_move parse_move(const game_state& state, const std::string& move);
+    static std::string format_score(int32_t score);
+public:
+    uci_engine();
+    ~uci_engine();
+    void run(std::istream& in, std::ostream& out);
+};
+
+
+#endif //CHESSUCIENGINE_UCI_ENGINE_H
@@ -4,15 +4,25 @@
 #include "chess_move_generator.h"
 #include <sstream>
 #include <chrono>
+#include <memory>
 
 using namespace std;
 
-string find_best_move(const string& fen, int depth) {
+string find_best_move(const string& fen, int depth, int threads, size_t hash_size_mb) {
+    // the evaluator is kept between calls, so the table and the history of the previous moves are reused
+    static unique_ptr<dynamic_evaluator> evaluator;
+    if (!evaluator) {
+        evaluator = make_unique<dynamic_evaluator>(threads, hash_size_mb);
+    } else if (evaluator->hash_size_mb != hash_size_mb) {
+        evaluator->set_hash_size(hash_size_mb);
+    }
+    evaluator->set_threads(threads);
     game_state state(fen);
     auto start = chrono::steady_clock::now();
-    dynamic_evaluator evaluator;
-    auto move = evaluator.find_best_move(state, depth);
-    cout << "find_best_move: " << chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count() << " ms" << endl;
+    auto move = evaluator->find_best_move(state, depth);
+    auto time = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+    cout << "find_best_move: " << time << " ms, " << evaluator->total_nodes << " nodes, " 
+         << evaluator->total_nodes * 1000 / max<int64_t>(time, 1) << " nps" << endl;
     stringstream ss;
     ss << move::to_string(move);
     return ss.str();
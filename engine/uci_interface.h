@@ -2,8 +2,10 @@
 #define CHESSUCIENGINE_UCI_INTERFACE_H
 
 #include <string>
+#include "transposition_table.h"
 
-std::string find_best_move(const std::string& fen, int depth);
+std::string find_best_move(const std::string& fen, int depth, int threads = 1,
+                           size_t hash_size_mb = transposition_table::DefaultSizeMb);
 
 bool is_mate(const std::string& fen);
 
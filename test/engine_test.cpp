@@ -2,9 +2,12 @@
 #include "../engine/dynamic_evaluator.h"
 #include "../engine/static_evaluator.h"
 #include "../engine/move_masks.h"
+#include "../engine/move_picker.h"
 #include "perft_utils.h"
 #include <chrono>
 #include <utility>
+#include <thread>
+#include <algorithm>
 
 using namespace std;
 
@@ -76,6 +79,141 @@ void run_tests(const vector<test_case>& cases) {
     }
 }
 
+// unmake_move must restore every field of the state, including the aggregate bitboards and the hash
+void check_unmake_move(const game_state& expected, game_state& state, const chess_move& move, const undo_info& undo) {
+    state.unmake_move(move, undo);
+    bool restored = state.board == expected.board && state.side_board == expected.side_board && 
+            state.inv_side_board == expected.inv_side_board && state.all == expected.all && 
+            state.empty == expected.empty && state.hash.value == expected.hash.value && state.fen() == expected.fen();
+    if (!restored) {
+        cerr << "\tUnmake mismatch: " << expected.fen() << ", move " << move::to_string(move) << endl;
+        exit(1);
+    }
+}
+
+// staged generation must produce the same moves as the full one, and the move validator must accept exactly
+// the generated moves, including moves that come from other positions of the tree
+void check_move_validation(const game_state& state, int depth, // NOLINT(misc-no-recursion)
+                           const move_list& parent_moves, const move_list& grandparent_moves) {
+    move_list moves, staged_moves;
+    chess_move_generator::generate_all_moves(moves, state, state.side);
+    chess_move_generator::generate_moves_of_type<chess_move_generator::move_type::Captures>(staged_moves, state, state.side);
+    chess_move_generator::generate_moves_of_type<chess_move_generator::move_type::Quiets>(staged_moves, state, state.side);
+    auto is_generated = [&moves](const chess_move& move) {
+        return find(moves.begin(), moves.end(), move) != moves.end();
+    };
+    bool staged_ok = staged_moves.size() == moves.size() && 
+            all_of(staged_moves.begin(), staged_moves.end(), is_generated);
+    if (!staged_ok) {
+        cerr << "\tStaged generation mismatch: " << state.fen() << endl;
+        exit(1);
+    }
+    for (const move_list* list : initializer_list<const move_list*> {&moves, &parent_moves, &grandparent_moves}) {
+        for (const auto& move: *list) {
+            if (chess_move_generator::is_valid_move(move, state) != is_generated(move)) {
+                cerr << "\tValidation mismatch: " << state.fen() << ", move " << move::to_string(move) << endl;
+                exit(1);
+            }
+        }
+    }
+    if (depth == 0) return;
+    for (const auto& move: moves) {
+        game_state new_state(state);
+        auto undo = new_state.apply_move(move);
+        check_move_validation(new_state, depth - 1, moves, parent_moves);
+        check_unmake_move(state, new_state, move, undo);
+    }
+}
+
+void run_move_validation_tests(const vector<test_case>& cases) {
+    for (const auto& test_case: cases) {
+        cout << "Move validation: " << test_case.fen << endl;
+        check_move_validation(game_state(test_case.fen), 3, move_list(), move_list());
+    }
+}
+
+// the picker must return every legal move exactly once, and captures losing material only after all quiet moves;
+// the hash move is the first move of the position and the killers are the quiet moves of the parent position
+void check_move_picker(const game_state& state, int depth, const move_list& parent_moves, // NOLINT(misc-no-recursion)
+                       search_frame& frame, const history_table& history) {
+    move_list moves;
+    chess_move_generator::generate_all_moves(moves, state, state.side);
+    chess_move hash_move = moves.size() > 0 ? moves[0] : move::Invalid;
+    frame.killers.clear();
+    for (const auto& move: parent_moves) {
+        if (move::is_quiet(move)) frame.killers.add(move);
+    }
+    vector<chess_move> picked;
+    move_picker picker(frame, state, hash_move, history, move::Invalid);
+    for (chess_move move = picker.next(); move::is_valid(move); move = picker.next()) {
+        picked.push_back(move);
+    }
+    bool each_once = picked.size() == moves.size() && all_of(moves.begin(), moves.end(), [&picked](const chess_move& move) {
+        return count(picked.begin(), picked.end(), move) == 1;
+    });
+    if (!each_once) {
+        cerr << "\tMove picker returned " << picked.size() << " moves of " << (int) moves.size() << ": " << state.fen() << endl;
+        exit(1);
+    }
+    auto is_losing = [&state](const chess_move& move) {
+        return !move::is_quiet(move) && static_evaluator::static_exchange(state, move) < 0;
+    };
+    auto last_quiet = find_if(picked.rbegin(), picked.rend(), [](const chess_move& move) { return move::is_quiet(move); });
+    auto quiets_end = last_quiet.base();
+    auto early_losing = find_if(picked.begin() + 1, quiets_end, is_losing);
+    if (!picked.empty() && early_losing < quiets_end) {
+        cerr << "\tMove picker returned losing capture " << move::to_string(*early_losing) << " before a quiet move: "
+             << state.fen() << endl;
+        exit(1);
+    }
+    if (depth == 0) return;
+    for (const auto& move: moves) {
+        game_state new_state(state);
+        new_state.apply_move(move);
+        check_move_picker(new_state, depth - 1, moves, frame, history);
+    }
+}
+
+void run_move_picker_tests(const vector<test_case>& cases) {
+    search_stack stack;
+    history_table history;
+    for (const auto& test_case: cases) {
+        cout << "Move picker: " << test_case.fen << endl;
+        check_move_picker(game_state(test_case.fen), 2, move_list(), stack[0], history);
+    }
+}
+
+chess_move find_move(const game_state& state, const string& move_string) {
+    move_list moves;
+    chess_move_generator::generate_all_moves(moves, state, state.side);
+    for (const auto& move: moves) {
+        if (move::to_string(move) == move_string) return move;
+    }
+    cerr << "\tMove " << move_string << " not found in " << state.fen() << endl;
+    exit(1);
+}
+
+void run_static_exchange_tests() {
+    vector<tuple<string, string, int32_t>> cases = {
+            {"1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "e1e5", 100},             // undefended pawn
+            {"1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "d3e5", -205},   // x-ray defenders behind
+            {"4k3/8/8/3p4/4p3/8/8/4Q1K1 w - - 0 1", "e1e4", -850},                          // queen takes defended pawn
+            {"4k3/8/8/3r4/8/8/3R4/3R2K1 w - - 0 1", "d2d5", 563},                           // rook behind the attacker
+            {"4k3/8/8/3r4/3r4/8/3R4/6K1 w - - 0 1", "d2d4", 0},                              // even rook exchange
+            {"8/8/8/2k5/3Pp3/8/8/4K3 b - d3 0 1", "e4d3", 100},                             // en passant
+    };
+    for (const auto& [fen, move_string, expected] : cases) {
+        game_state state(fen);
+        auto actual = static_evaluator::static_exchange(state, find_move(state, move_string));
+        if (actual != expected) {
+            cerr << "\tStatic exchange of " << move_string << " in " << fen << ": expected " << expected 
+                 << ", actual " << actual << endl;
+            exit(1);
+        }
+    }
+    cout << "Static exchange: ok" << endl;
+}
+
 void test_starting_value_zero() {
     game_state state("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w - - 0 1");
     Assert(static_evaluator::evaluate(state) == 0)
@@ -91,6 +229,19 @@ void perft_test(int depth) {
 //    cout << "Nodes searched: " << total << endl;
 }
 
+void threads_scaling_test(int depth) {
+    game_state state("r1b2rk1/1pp5/p2bp2p/3nNp1q/P1PP2p1/3B4/1P2QPP1/R1B1R1K1 b - - 0 18");
+    int max_threads = max(1, (int) thread::hardware_concurrency());
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        dynamic_evaluator evaluator(threads);
+        auto start = chrono::steady_clock::now();
+        evaluator.find_best_move(state, depth);
+        auto time = chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - start).count();
+        cout << "Threads: " << threads << ", time to depth " << depth << ": " << time << " ms, nodes: " << evaluator.total_nodes
+             << ", nps: " << evaluator.total_nodes * 1000 / max<int64_t>(time, 1) << endl;
+    }
+}
+
 int main() {
     vector<test_case> test_cases = {
             {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", {1, 20, 400, 8902, 197281, 4865609}},
@@ -102,12 +253,16 @@ int main() {
             {"rnbqkb1r/ppp2ppp/3pp3/8/PPPPPPP1/5n1P/8/RNBQKBNR w KQkq - 0 1", {1, 4, 124, 4061, 126842, 4267678}},
     };
     run_tests(test_cases);
+    run_move_validation_tests(test_cases);
+    run_move_picker_tests(test_cases);
+    run_static_exchange_tests();
     performance_test([](){ perft_test(5); }); // 744 ms -> 488 ms -> 477 ms
     performance_test([]() { // 840 ms -> 530 ms -> 508 ms -> 472 ms
         game_state state("r1b2rk1/1pp5/p2bp2p/3nNp1q/P1PP2p1/3B4/1P2QPP1/R1B1R1K1 b - - 0 18");
         dynamic_evaluator evaluator;
         evaluator.find_best_move(state, 8);
     });
+    threads_scaling_test(8);
     return 0;
 
     size_t total = 0;
@@ -128,13 +283,14 @@ int main() {
     auto diff = chrono::steady_clock::now() - start;
     cout << chrono::duration_cast<chrono::milliseconds>(diff).count() << " ms" << endl;
     cout << "Best move: " << move::to_string(move) << endl;
-    cout << "Max depth: " << evaluator.max_depth << endl;
-    cout << "Total nodes in main search: " << evaluator.main_search_nodes << endl;
-    cout << "Total nodes in zero window search: " << evaluator.zero_window_nodes << endl;
-    cout << "Total nodes in capture search: " << evaluator.capture_search_nodes << endl;
-    cout << "Found entry in transposition table: " << evaluator.transposition_found << endl;
-    cout << "Move from transposition table was best: " << evaluator.transposition_best_hit << endl;
-    cout << "PVS research count: " << evaluator.pvs_research_count << endl;
+    auto stats = evaluator.statistics();
+    cout << "Max depth: " << stats.max_depth << endl;
+    cout << "Total nodes in main search: " << stats[search_statistics::MainSearchNodes] << endl;
+    cout << "Total nodes in zero window search: " << stats[search_statistics::ZeroWindowNodes] << endl;
+    cout << "Total nodes in capture search: " << stats[search_statistics::CaptureSearchNodes] << endl;
+    cout << "Found entry in transposition table: " << stats[search_statistics::TranspositionFound] << endl;
+    cout << "Move from transposition table was best: " << stats[search_statistics::TranspositionBestHit] << endl;
+    cout << "PVS research count: " << stats[search_statistics::PvsResearches] << endl;
 
     return 0;
 }
\ No newline at end of file
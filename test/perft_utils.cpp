@@ -9,30 +9,30 @@ std::vector<pair<chess_move, size_t>> perft_utils::perft(const string& fen, int
     move_list& moves = pool.init_list(depth);
     chess_move_generator::generate_all_moves(moves, state, state.side);
     for (const auto& move: moves) {
-        game_state new_state(state);
-        new_state.apply_move(move);
-        auto nodes = perft_inner(new_state, pool, depth - 1);
+        auto undo = state.apply_move(move);
+        auto nodes = perft_inner(state, pool, depth - 1);
+        state.unmake_move(move, undo);
         result.emplace_back(move, nodes);
     }
     return result;
 }
 
-size_t perft_utils::perft_inner(const game_state& state, move_list_pool& pool, int depth) { // NOLINT(misc-no-recursion)
+size_t perft_utils::perft_inner(game_state& state, move_list_pool& pool, int depth) { // NOLINT(misc-no-recursion)
     if (depth == 0) return 1;
     size_t result = 0;
     move_list& moves = pool.init_list(depth);
     chess_move_generator::generate_all_moves(moves, state, state.side);
     if (depth == 1) return moves.size();
     for (const auto& move: moves) {
-        game_state new_state(state);
-        new_state.apply_move(move);
+        auto undo = state.apply_move(move);
         if (depth > 2) {
-            result += perft_inner(new_state, pool, depth - 1);
+            result += perft_inner(state, pool, depth - 1);
         } else {
             move_list& new_moves = pool.init_list(depth - 1);
-            chess_move_generator::generate_all_moves(new_moves, new_state, new_state.side);
+            chess_move_generator::generate_all_moves(new_moves, state, state.side);
             result += new_moves.size();
         }
+        state.unmake_move(move, undo);
     }
     return result;
 }
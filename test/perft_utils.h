@@ -7,7 +7,7 @@
 #include <vector>
 
 class perft_utils {
-    static size_t perft_inner(const game_state& state, move_list_pool& pool, int depth);
+    static size_t perft_inner(game_state& state, move_list_pool& pool, int depth);
 public:
     static std::vector<std::pair<chess_move, size_t>> perft(const std::string& fen, int depth);
 };